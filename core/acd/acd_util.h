@@ -10,12 +10,24 @@
 #include <set>
 #include <map>
 #include <queue>
+#include <array>
 
 typedef struct triangle {
     uint32_t indices[3];
     std::set<uint32_t> neighbors;
 } Triangle;
 
+typedef struct mergeCandidate {
+    float cost;
+    uint32_t clusterA, clusterB;
+    uint32_t versionA, versionB;
+    
+    bool operator>(const mergeCandidate& other) const { return cost > other.cost; }
+} MergeCandidate;
+
+// Mesh::vertices are interleaved position, normal, uv
+typedef VertexLayout<PositionAttribute, NormalAttribute, UVAttribute> MeshLayout;
+
 typedef struct mesh {
     std::vector<float> vertices;
     std::vector<uint32_t> indices;
@@ -23,23 +35,16 @@ typedef struct mesh {
     glm::vec3 color;
 } Mesh;
 
+// Ranges of a Mesh that were rewritten in place; triangles are counted in index triples. Anything past
+// the old end of the mesh is treated as edited as well.
+typedef struct meshEdit {
+    uint32_t firstVertex, vertexCount;
+    uint32_t firstTriangle, triangleCount;
+} MeshEdit;
+
 typedef struct convexHull {
     std::vector<glm::vec3> vertices;
     std::vector<std::array<int, 3>> faces;
 } ConvexHull;
 
-std::vector<float> GetTransformedVertices(Mesh mesh, glm::mat4 model) {
-    
-    std::vector<float> projectedVertices = std::vector<float>();
-    
-    for (int i = 0; i < mesh.vertices.size()/8; i++) {
-        glm::vec3 vertex = glm::vec3(mesh.vertices[i * 8], mesh.vertices[i * 8 + 1], mesh.vertices[i * 8 + 2]);
-        glm::vec3 projected = glm::vec3(model * glm::vec4(vertex, 1.0));
-        projectedVertices.push_back(projected.x);
-        projectedVertices.push_back(projected.y);
-        projectedVertices.push_back(projected.z);
-    }
-    return projectedVertices;
-}
-
 #endif /* acd_util_h */
@@ -0,0 +1,343 @@
+//
+//  concavity.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-18.
+//
+
+#ifndef concavity_h
+#define concavity_h
+
+#include <cfloat>
+
+#define ACD_MAX_CONCAVITY_SAMPLES 64
+#define ACD_VOLUME_WEIGHT 0.5f
+
+typedef struct concavitySample {
+    glm::vec3 position;
+    glm::vec3 normal;
+    float distance;
+} ConcavitySample;
+
+// Hull face planes as padded structure-of-arrays so the ray loop runs four planes at a time.
+typedef struct hullPlanes {
+    std::vector<float> normalX, normalY, normalZ, offset;
+} HullPlanes;
+
+// Everything the clustering loop needs to know about a cluster of triangles. The volume terms are
+// kept as sums so merging two clusters never has to revisit their triangles.
+typedef struct concavityCluster {
+    std::vector<uint32_t> triangles;
+    std::vector<uint32_t> vertices;
+    std::vector<ConcavitySample> samples;
+    ConvexHull hull;
+    glm::vec3 boundsMin, boundsMax;
+    glm::vec3 areaVector;
+    float surfaceArea;
+    float originVolume;
+    float hullVolume;
+    float meshVolume;
+    float surfaceDistance;
+    float concavity;
+} ConcavityCluster;
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Hull measurements //
+// ------------------------------------------------------------------------------------------------------------- //
+
+float ComputeHullVolume(const ConvexHull& hull) {
+    
+    if (hull.vertices.empty()) return 0.0f;
+    
+    const glm::vec3& origin = hull.vertices[0];
+    float volume = 0.0f;
+    for (const std::array<int, 3>& face : hull.faces) {
+        volume += glm::dot(hull.vertices[face[0]] - origin, glm::cross(hull.vertices[face[1]] - origin, hull.vertices[face[2]] - origin));
+    }
+    return glm::abs(volume) / 6.0f;
+}
+
+glm::vec3 ComputeHullCentroid(const ConvexHull& hull) {
+    
+    glm::vec3 centroid = glm::vec3(0.0f);
+    for (const glm::vec3& vertex : hull.vertices) {
+        centroid += vertex;
+    }
+    return hull.vertices.empty() ? centroid : centroid / (float)hull.vertices.size();
+}
+
+// The face planes of a flat hull only bound its thickness, so it also needs a plane through every
+// boundary edge, standing on the polygon and facing out, to keep rays and points to the polygon itself.
+// Returns them as (normal, offset); closed hulls and hulls without area get none.
+std::vector<glm::vec4> ComputeEdgePlanes(const ConvexHull& hull) {
+    
+    std::vector<glm::vec4> edgePlanes;
+    
+    glm::vec3 normal = glm::vec3(0.0f);
+    float largest = 0.0f;
+    for (const std::array<int, 3>& face : hull.faces) {
+        const glm::vec3& A = hull.vertices[face[0]];
+        glm::vec3 faceNormal = glm::cross(hull.vertices[face[1]] - A, hull.vertices[face[2]] - A);
+        if (glm::dot(faceNormal, faceNormal) > largest) {
+            largest = glm::dot(faceNormal, faceNormal);
+            normal = faceNormal;
+        }
+    }
+    if (largest <= 0.0f) return edgePlanes;
+    normal = glm::normalize(normal);
+    
+    // Flat to the same tolerance BuildConvexHull uses to call points coplanar
+    glm::vec3 boundsMin = hull.vertices[0], boundsMax = hull.vertices[0];
+    for (const glm::vec3& vertex : hull.vertices) {
+        boundsMin = glm::min(boundsMin, vertex);
+        boundsMax = glm::max(boundsMax, vertex);
+    }
+    const float epsilon = std::max(glm::length(boundsMax - boundsMin), 1e-6f) * 1e-5f;
+    float height = glm::dot(normal, hull.vertices[0]);
+    for (const glm::vec3& vertex : hull.vertices) {
+        if (glm::abs(glm::dot(normal, vertex) - height) > epsilon) return edgePlanes;
+    }
+    
+    // Of the faces on one side, each interior edge is shared by two and each boundary edge used by one
+    std::unordered_map<uint64_t, int> edgeUses;
+    for (const std::array<int, 3>& face : hull.faces) {
+        const glm::vec3& A = hull.vertices[face[0]];
+        if (glm::dot(glm::cross(hull.vertices[face[1]] - A, hull.vertices[face[2]] - A), normal) <= 0.0f) continue;
+        for (int edge = 0; edge < 3; edge++) {
+            uint64_t a = (uint64_t)face[edge], b = (uint64_t)face[(edge + 1) % 3];
+            edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    
+    glm::vec3 centroid = ComputeHullCentroid(hull);
+    for (const std::pair<const uint64_t, int>& edge : edgeUses) {
+        if (edge.second != 1) continue;
+        
+        const glm::vec3& A = hull.vertices[edge.first >> 32];
+        const glm::vec3& B = hull.vertices[edge.first & 0xFFFFFFFFull];
+        glm::vec3 side = glm::cross(B - A, normal);
+        float length = glm::length(side);
+        if (length < 1e-12f) continue;
+        
+        side /= length;
+        if (glm::dot(side, centroid - A) > 0.0f) side = -side;
+        edgePlanes.push_back(glm::vec4(side, glm::dot(side, A)));
+    }
+    return edgePlanes;
+}
+
+HullPlanes ComputeHullPlanes(const ConvexHull& hull) {
+    
+    HullPlanes planes;
+    size_t padded = (hull.faces.size() + 3) & ~(size_t)3;
+    planes.normalX.assign(padded, 0.0f);
+    planes.normalY.assign(padded, 0.0f);
+    planes.normalZ.assign(padded, 0.0f);
+    planes.offset.assign(padded, FLT_MAX);
+    
+    for (size_t i = 0; i < hull.faces.size(); i++) {
+        const glm::vec3& A = hull.vertices[hull.faces[i][0]];
+        glm::vec3 normal = glm::cross(hull.vertices[hull.faces[i][1]] - A, hull.vertices[hull.faces[i][2]] - A);
+        float length = glm::length(normal);
+        if (length < 1e-12f) continue;
+        
+        normal /= length;
+        planes.normalX[i] = normal.x;
+        planes.normalY[i] = normal.y;
+        planes.normalZ[i] = normal.z;
+        planes.offset[i]  = glm::dot(normal, A);
+    }
+    return planes;
+}
+
+// Distance from a point inside the hull to its boundary along direction. For an interior origin this is
+// the nearest RayIntersectTriangle hit over the hull faces, but evaluated against the face planes.
+float HullExitDistance(const HullPlanes& planes, const glm::vec3& origin, const glm::vec3& direction) {
+    
+    const float4 originX = Float4Set(origin.x), originY = Float4Set(origin.y), originZ = Float4Set(origin.z);
+    const float4 directionX = Float4Set(direction.x), directionY = Float4Set(direction.y), directionZ = Float4Set(direction.z);
+    const float4 epsilon = Float4Set(1e-12f);
+    const float4 none = Float4Set(FLT_MAX);
+    
+    float4 nearest = none;
+    for (size_t i = 0; i < planes.offset.size(); i += 4) {
+        float4 normalX = Float4Load(&planes.normalX[i]);
+        float4 normalY = Float4Load(&planes.normalY[i]);
+        float4 normalZ = Float4Load(&planes.normalZ[i]);
+        
+        float4 facing = Float4Add(Float4Add(Float4Mul(normalX, directionX), Float4Mul(normalY, directionY)), Float4Mul(normalZ, directionZ));
+        float4 height = Float4Add(Float4Add(Float4Mul(normalX, originX), Float4Mul(normalY, originY)), Float4Mul(normalZ, originZ));
+        float4 gap    = Float4Sub(Float4Load(&planes.offset[i]), height);
+        
+        float4 mask = Float4Greater(facing, epsilon);
+        float4 t = Float4Div(gap, Float4Select(mask, facing, Float4Set(1.0f)));
+        nearest = Float4Min(nearest, Float4Select(mask, t, none));
+    }
+    
+    float distance = Float4HorizontalMin(nearest);
+    return distance == FLT_MAX ? 0.0f : std::max(distance, 0.0f);
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Cluster construction //
+// ------------------------------------------------------------------------------------------------------------- //
+
+std::vector<glm::vec3> GetMeshPositions(const Mesh& mesh) {
+    return ExtractPositions<MeshLayout>(mesh.vertices);
+}
+
+ConcavityCluster CreateConcavityCluster(const std::vector<glm::vec3>& positions, const Triangle& triangle, uint32_t triangleIndex) {
+    
+    ConcavityCluster cluster;
+    const glm::vec3& A = positions[triangle.indices[0]];
+    const glm::vec3& B = positions[triangle.indices[1]];
+    const glm::vec3& C = positions[triangle.indices[2]];
+    
+    cluster.triangles = {triangleIndex};
+    cluster.vertices = {triangle.indices[0], triangle.indices[1], triangle.indices[2]};
+    std::sort(cluster.vertices.begin(), cluster.vertices.end());
+    cluster.vertices.erase(std::unique(cluster.vertices.begin(), cluster.vertices.end()), cluster.vertices.end());
+    
+    cluster.boundsMin = glm::min(A, glm::min(B, C));
+    cluster.boundsMax = glm::max(A, glm::max(B, C));
+    cluster.areaVector = glm::cross(B - A, C - A);
+    cluster.originVolume = glm::dot(A, glm::cross(B, C)) / 6.0f;
+    
+    cluster.surfaceArea = 0.5f * glm::length(cluster.areaVector);
+    if (cluster.surfaceArea > 1e-12f) {
+        cluster.samples.push_back({(A + B + C) / 3.0f, glm::normalize(cluster.areaVector), 0.0f});
+    }
+    
+    cluster.hull.vertices = {A, B, C};
+    cluster.hull.faces = {{0, 1, 2}, {0, 2, 1}};
+    cluster.hullVolume = 0.0f;
+    cluster.meshVolume = 0.0f;
+    cluster.surfaceDistance = 0.0f;
+    cluster.concavity = 0.0f;
+    return cluster;
+}
+
+// Measures the samples against the hull and keeps only the deepest ones, which are the ones that
+// will still dominate the concavity after further merges.
+void EvaluateConcavity(ConcavityCluster& cluster) {
+    
+    cluster.hullVolume = ComputeHullVolume(cluster.hull);
+    
+    // Mesh volume closed off at the hull centroid: V(c) = V(0) - dot(c, sum of area vectors) / 6
+    glm::vec3 centroid = ComputeHullCentroid(cluster.hull);
+    cluster.meshVolume = glm::abs(cluster.originVolume - glm::dot(centroid, cluster.areaVector) / 6.0f);
+    
+    HullPlanes planes = ComputeHullPlanes(cluster.hull);
+    cluster.surfaceDistance = 0.0f;
+    for (ConcavitySample& sample : cluster.samples) {
+        sample.distance = HullExitDistance(planes, sample.position, sample.normal);
+        cluster.surfaceDistance = std::max(cluster.surfaceDistance, sample.distance);
+    }
+    
+    if (cluster.samples.size() > ACD_MAX_CONCAVITY_SAMPLES) {
+        std::nth_element(cluster.samples.begin(), cluster.samples.begin() + ACD_MAX_CONCAVITY_SAMPLES, cluster.samples.end(),
+                         [](const ConcavitySample& A, const ConcavitySample& B) { return A.distance > B.distance; });
+        cluster.samples.resize(ACD_MAX_CONCAVITY_SAMPLES);
+    }
+    
+    // The volume gap only means something once the cluster is closed; an open patch is judged by distance alone
+    cluster.concavity = cluster.surfaceDistance;
+    if (0.5f * glm::length(cluster.areaVector) < 1e-3f * cluster.surfaceArea) {
+        float volumeGap = std::max(cluster.hullVolume - cluster.meshVolume, 0.0f);
+        cluster.concavity = std::max(cluster.concavity, ACD_VOLUME_WEIGHT * std::cbrt(volumeGap));
+    }
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Merging //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// hull(A ∪ B) from the two hulls alone. The hull of a union is the hull of the union of the hulls, so a
+// candidate costs O(hull size) whatever the size of the clusters, and a vertex strictly inside the other
+// hull can't be on the merged hull and is dropped before building it. Inside is decided exactly, so a
+// vertex on or near the other hull's boundary is kept rather than guessed at.
+ConvexHull MergeConvexHulls(const ConvexHull& A, const ConvexHull& B) {
+    
+    // Flat hulls have two opposite faces per triangle, so nothing is ever strictly inside them
+    auto keepOutside = [](const ConvexHull& from, const ConvexHull& other, std::vector<glm::vec3>& points) {
+        if (other.faces.size() < 4) {
+            points.insert(points.end(), from.vertices.begin(), from.vertices.end());
+            return;
+        }
+        std::vector<OrientPlane> planes;
+        planes.reserve(other.faces.size());
+        for (const std::array<int, 3>& face : other.faces) {
+            planes.push_back(CreateOrientPlane(other.vertices[face[0]], other.vertices[face[1]], other.vertices[face[2]]));
+        }
+        for (const glm::vec3& vertex : from.vertices) {
+            bool inside = true;
+            for (size_t i = 0; i < planes.size() && inside; i++) {
+                inside = Orient3D(planes[i], vertex) < 0.0;
+            }
+            if (!inside) points.push_back(vertex);
+        }
+    };
+    
+    std::vector<glm::vec3> points;
+    points.reserve(A.vertices.size() + B.vertices.size());
+    keepOutside(A, B, points);
+    keepOutside(B, A, points);
+    return BuildConvexHull(points);
+}
+
+// Merges everything but the triangle and vertex lists, which only the committed merge needs. hull is
+// hull(A ∪ B), from MergeConvexHulls or the candidate cache.
+ConcavityCluster MergeConcavityMeasures(const ConcavityCluster& A, const ConcavityCluster& B, ConvexHull hull) {
+    
+    ConcavityCluster merged;
+    merged.samples.reserve(A.samples.size() + B.samples.size());
+    merged.samples.insert(merged.samples.end(), A.samples.begin(), A.samples.end());
+    merged.samples.insert(merged.samples.end(), B.samples.begin(), B.samples.end());
+    
+    merged.boundsMin = glm::min(A.boundsMin, B.boundsMin);
+    merged.boundsMax = glm::max(A.boundsMax, B.boundsMax);
+    merged.areaVector = A.areaVector + B.areaVector;
+    merged.surfaceArea = A.surfaceArea + B.surfaceArea;
+    merged.originVolume = A.originVolume + B.originVolume;
+    merged.hull = std::move(hull);
+    
+    EvaluateConcavity(merged);
+    return merged;
+}
+
+ConcavityCluster MergeConcavityClusters(const ConcavityCluster& A, const ConcavityCluster& B, ConvexHull hull) {
+    
+    ConcavityCluster merged = MergeConcavityMeasures(A, B, std::move(hull));
+    merged.triangles.reserve(A.triangles.size() + B.triangles.size());
+    merged.triangles.insert(merged.triangles.end(), A.triangles.begin(), A.triangles.end());
+    merged.triangles.insert(merged.triangles.end(), B.triangles.begin(), B.triangles.end());
+    
+    merged.vertices.reserve(A.vertices.size() + B.vertices.size());
+    std::set_union(A.vertices.begin(), A.vertices.end(), B.vertices.begin(), B.vertices.end(), std::back_inserter(merged.vertices));
+    return merged;
+}
+
+// Concavity of A∪B for every candidate pair, spread over the thread pool. hulls[i] is hull(A ∪ B) of
+// candidate i, for the caller to keep until the pair is merged or goes stale.
+void EvaluateMergeCosts(const std::vector<ConcavityCluster>& clusters, const std::vector<std::pair<uint32_t, uint32_t>>& candidates,
+                        std::vector<float>& costs, std::vector<ConvexHull>& hulls) {
+    
+    costs.resize(candidates.size());
+    hulls.resize(candidates.size());
+    threadPool.ParallelFor(candidates.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const ConcavityCluster& A = clusters[candidates[i].first];
+            const ConcavityCluster& B = clusters[candidates[i].second];
+            hulls[i] = MergeConvexHulls(A.hull, B.hull);
+            costs[i] = MergeConcavityMeasures(A, B, hulls[i]).concavity;
+        }
+    });
+}
+
+#endif /* concavity_h */
@@ -0,0 +1,178 @@
+//
+//  congruence.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef congruence_h
+#define congruence_h
+
+#define ACD_CONGRUENCE_TOLERANCE 1e-4f
+
+// Where a mesh sits, described by points that move rigidly with it: its centroid and two anchor vertices,
+// the one furthest from the centroid and the one furthest off that line. topology is a hash of the
+// counts and the index buffer, which copies of the same geometry share exactly, so vertex i of a copy
+// is the counterpart of vertex i of its source and the anchors carry over by index.
+typedef struct meshFrame {
+    glm::vec3 centroid;
+    uint32_t anchors[2];
+    float radius;
+    uint64_t topology;
+} MeshFrame;
+
+// Mesh source of every mesh, and the rigid transform that moves source onto it. source is the mesh
+// itself for meshes that have to be decomposed.
+typedef struct meshInstance {
+    size_t source;
+    glm::mat4 transform;
+} MeshInstance;
+
+MeshFrame ComputeMeshFrame(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    
+    MeshFrame frame{};
+    uint64_t hash = 1469598103934665603ull ^ positions.size();
+    for (uint32_t index : indices) {
+        hash = (hash ^ index) * 1099511628211ull;
+    }
+    frame.topology = hash ^ ((uint64_t)indices.size() << 32);
+    if (positions.empty()) return frame;
+    
+    glm::dvec3 sum = glm::dvec3(0.0);
+    for (const glm::vec3& P : positions) sum += glm::dvec3(P);
+    frame.centroid = glm::vec3(sum / (double)positions.size());
+    
+    float furthest = -1.0f, offLine = -1.0f;
+    for (uint32_t i = 0; i < positions.size(); i++) {
+        float distance = glm::length(positions[i] - frame.centroid);
+        if (distance > furthest) {
+            furthest = distance;
+            frame.anchors[0] = i;
+        }
+    }
+    frame.radius = furthest;
+    
+    glm::vec3 axis = positions[frame.anchors[0]] - frame.centroid;
+    for (uint32_t i = 0; i < positions.size(); i++) {
+        float distance = glm::length(glm::cross(positions[i] - frame.centroid, axis));
+        if (distance > offLine) {
+            offLine = distance;
+            frame.anchors[1] = i;
+        }
+    }
+    return frame;
+}
+
+// Orthonormal basis (columns) spanned by the centroid and the anchors of source, taken at positions.
+glm::mat3 GetAnchorBasis(const std::vector<glm::vec3>& positions, const glm::vec3& centroid, const MeshFrame& source) {
+    
+    glm::vec3 u = positions[source.anchors[0]] - centroid;
+    glm::vec3 v = positions[source.anchors[1]] - centroid;
+    glm::vec3 normal = glm::cross(u, v);
+    if (glm::length(normal) <= 0.0f || glm::length(u) <= 0.0f) return glm::mat3(0.0f);
+    
+    glm::vec3 e1 = glm::normalize(u);
+    glm::vec3 e3 = glm::normalize(normal);
+    return glm::mat3(e1, glm::cross(e3, e1), e3);
+}
+
+// Rotation and translation taking the anchors of source onto their counterparts in copy. Every vertex
+// then has to land within tolerance of its counterpart, which also rejects mirrored and scaled copies.
+bool MatchCongruentMesh(const std::vector<glm::vec3>& source, const MeshFrame& sourceFrame,
+                        const std::vector<glm::vec3>& copy, const MeshFrame& copyFrame, glm::mat4& transform) {
+    
+    if (source.size() != copy.size() || source.empty() || sourceFrame.topology != copyFrame.topology) return false;
+    
+    float tolerance = ACD_CONGRUENCE_TOLERANCE * std::max(sourceFrame.radius, 1e-30f);
+    if (std::abs(sourceFrame.radius - copyFrame.radius) > tolerance) return false;
+    
+    glm::mat3 sourceBasis = GetAnchorBasis(source, sourceFrame.centroid, sourceFrame);
+    glm::mat3 copyBasis = GetAnchorBasis(copy, copyFrame.centroid, sourceFrame);
+    if (sourceBasis[2] == glm::vec3(0.0f) || copyBasis[2] == glm::vec3(0.0f)) return false;
+    
+    glm::mat3 sourceInverse = glm::transpose(sourceBasis);
+    glm::mat3 rotation;
+    for (int j = 0; j < 3; j++) {
+        rotation[j] = copyBasis * sourceInverse[j];
+    }
+    
+    for (size_t i = 0; i < source.size(); i++) {
+        glm::vec3 mapped = copyFrame.centroid + rotation * (source[i] - sourceFrame.centroid);
+        if (glm::length(mapped - copy[i]) > tolerance) return false;
+    }
+    
+    transform = glm::mat4(rotation);
+    transform[3] = glm::vec4(copyFrame.centroid - rotation * sourceFrame.centroid, 1.0f);
+    return true;
+}
+
+// Groups congruent meshes: each mesh is matched against the earlier meshes with the same topology that
+// were decomposed themselves, so a source always comes before its copies.
+std::vector<MeshInstance> FindCongruentMeshes(const std::vector<Mesh>& meshes) {
+    
+    std::vector<MeshFrame> frames(meshes.size());
+    threadPool.ParallelFor(meshes.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) frames[i] = ComputeMeshFrame(GetMeshPositions(meshes[i]), meshes[i].indices);
+    });
+    
+    std::vector<MeshInstance> instances(meshes.size());
+    std::unordered_map<uint64_t, std::vector<size_t>> sources;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        instances[i] = MeshInstance{i, glm::mat4(1.0f)};
+        
+        std::vector<size_t>& candidates = sources[frames[i].topology];
+        if (!candidates.empty()) {
+            std::vector<glm::vec3> positions = GetMeshPositions(meshes[i]);
+            for (size_t candidate : candidates) {
+                if (MatchCongruentMesh(GetMeshPositions(meshes[candidate]), frames[candidate], positions, frames[i], instances[i].transform)) {
+                    instances[i].source = candidate;
+                    break;
+                }
+            }
+        }
+        if (instances[i].source == i) candidates.push_back(i);
+    }
+    return instances;
+}
+
+ConvexHull TransformHull(const ConvexHull& hull, const glm::mat4& transform) {
+    
+    ConvexHull moved = hull;
+    for (glm::vec3& vertex : moved.vertices) {
+        vertex = glm::vec3(transform * glm::vec4(vertex, 1.0f));
+    }
+    return moved;
+}
+
+// The cluster of a congruent copy. Rigid motions keep every measure except the position-dependent ones:
+// the area vector turns with the mesh and the volume about the origin picks up the translation,
+// V'(0) = V(0) + dot(t, R areaVector) / 6.
+ConcavityCluster TransformCluster(const ConcavityCluster& cluster, const glm::mat4& transform) {
+    
+    ConcavityCluster moved = cluster;
+    glm::mat3 rotation = glm::mat3(transform);
+    glm::vec3 translation = glm::vec3(transform[3]);
+    
+    moved.hull = TransformHull(cluster.hull, transform);
+    for (ConcavitySample& sample : moved.samples) {
+        sample.position = glm::vec3(transform * glm::vec4(sample.position, 1.0f));
+        sample.normal = rotation * sample.normal;
+    }
+    moved.areaVector = rotation * cluster.areaVector;
+    moved.originVolume = cluster.originVolume + glm::dot(translation, moved.areaVector) / 6.0f;
+    
+    // The hull's extreme points bound the cluster's vertices exactly
+    moved.boundsMin = glm::vec3(FLT_MAX);
+    moved.boundsMax = glm::vec3(-FLT_MAX);
+    for (const glm::vec3& vertex : moved.hull.vertices) {
+        moved.boundsMin = glm::min(moved.boundsMin, vertex);
+        moved.boundsMax = glm::max(moved.boundsMax, vertex);
+    }
+    if (moved.hull.vertices.empty()) {
+        moved.boundsMin = glm::vec3(rotation * cluster.boundsMin + translation);
+        moved.boundsMax = moved.boundsMin;
+    }
+    return moved;
+}
+
+#endif /* congruence_h */
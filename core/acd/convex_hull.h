@@ -0,0 +1,277 @@
+//
+//  convex_hull.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-18.
+//
+
+#ifndef convex_hull_h
+#define convex_hull_h
+
+#include <array>
+#include <limits>
+#include <unordered_map>
+
+typedef struct hullBuildFace {
+    int vertices[3];
+    glm::vec3 normal;
+    float offset;
+    std::vector<int> outside;
+    bool alive;
+} HullBuildFace;
+
+inline uint64_t HullEdgeKey(int a, int b) {
+    return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Planar hulls //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Flat point sets have no volume, so they are emitted as a two-sided polygon in their plane.
+ConvexHull BuildPlanarHull(const std::vector<glm::vec3>& points, const glm::vec3& normal) {
+    
+    ConvexHull hull;
+    
+    glm::vec3 axisU = glm::abs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    axisU = glm::normalize(glm::cross(normal, axisU));
+    glm::vec3 axisV = glm::cross(normal, axisU);
+    
+    std::vector<std::pair<glm::vec2, int>> projected;
+    projected.reserve(points.size());
+    for (int i = 0; i < (int)points.size(); i++) {
+        projected.push_back({glm::vec2(glm::dot(points[i], axisU), glm::dot(points[i], axisV)), i});
+    }
+    std::sort(projected.begin(), projected.end(), [](const std::pair<glm::vec2, int>& A, const std::pair<glm::vec2, int>& B) {
+        return A.first.x < B.first.x || (A.first.x == B.first.x && A.first.y < B.first.y);
+    });
+    
+    auto turn = [](const glm::vec2& O, const glm::vec2& A, const glm::vec2& B) {
+        return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
+    };
+    
+    // Andrew's monotone chain
+    std::vector<int> chain(2 * projected.size());
+    int k = 0;
+    for (size_t i = 0; i < projected.size(); i++) {
+        while (k >= 2 && turn(projected[chain[k - 2]].first, projected[chain[k - 1]].first, projected[i].first) <= 0.0f) k--;
+        chain[k++] = (int)i;
+    }
+    for (int i = (int)projected.size() - 2, lower = k + 1; i >= 0; i--) {
+        while (k >= lower && turn(projected[chain[k - 2]].first, projected[chain[k - 1]].first, projected[i].first) <= 0.0f) k--;
+        chain[k++] = i;
+    }
+    chain.resize(std::max(k - 1, 0));
+    
+    for (int index : chain) {
+        hull.vertices.push_back(points[projected[index].second]);
+    }
+    for (int i = 1; i + 1 < (int)hull.vertices.size(); i++) {
+        hull.faces.push_back({0, i, i + 1});
+        hull.faces.push_back({0, i + 1, i});
+    }
+    return hull;
+}
+
+// ------------------------------------------------------------------------------------------------------------- //
+// BuildConvexHull //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Quickhull. Faces are wound counter-clockwise seen from outside, so cross(B - A, C - A) points outward.
+ConvexHull BuildConvexHull(const std::vector<glm::vec3>& points) {
+    
+    ConvexHull hull;
+    if (points.empty()) return hull;
+    
+    // Initial simplex: extreme points along the axes, then the farthest from that line and plane
+    int extremes[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < (int)points.size(); i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (points[i][axis] < points[extremes[axis * 2]][axis])     extremes[axis * 2]     = i;
+            if (points[i][axis] > points[extremes[axis * 2 + 1]][axis]) extremes[axis * 2 + 1] = i;
+        }
+    }
+    
+    int i0 = extremes[0], i1 = extremes[1];
+    float widest = -1.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        float width = glm::length(points[extremes[axis * 2 + 1]] - points[extremes[axis * 2]]);
+        if (width > widest) {
+            widest = width;
+            i0 = extremes[axis * 2];
+            i1 = extremes[axis * 2 + 1];
+        }
+    }
+    
+    const float epsilon = std::max(widest, 1e-6f) * 1e-5f;
+    if (widest <= epsilon) {
+        hull.vertices.push_back(points[i0]);
+        return hull;
+    }
+    
+    glm::vec3 line = glm::normalize(points[i1] - points[i0]);
+    int i2 = -1;
+    float farthest = epsilon;
+    for (int i = 0; i < (int)points.size(); i++) {
+        float distance = glm::length(glm::cross(points[i] - points[i0], line));
+        if (distance > farthest) {
+            farthest = distance;
+            i2 = i;
+        }
+    }
+    if (i2 < 0) {
+        hull.vertices.push_back(points[i0]);
+        hull.vertices.push_back(points[i1]);
+        return hull;
+    }
+    
+    glm::vec3 planeNormal = glm::normalize(glm::cross(points[i1] - points[i0], points[i2] - points[i0]));
+    int i3 = -1;
+    farthest = epsilon;
+    for (int i = 0; i < (int)points.size(); i++) {
+        float distance = glm::abs(glm::dot(points[i] - points[i0], planeNormal));
+        if (distance > farthest) {
+            farthest = distance;
+            i3 = i;
+        }
+    }
+    if (i3 < 0) {
+        return BuildPlanarHull(points, planeNormal);
+    }
+    
+    // A hull of n points has at most 2n - 4 faces, each holding three edges
+    std::vector<HullBuildFace> faces;
+    std::unordered_map<uint64_t, int> edgeFaces;
+    faces.reserve(2 * points.size());
+    edgeFaces.reserve(6 * points.size());
+    
+    auto addFace = [&](int a, int b, int c) {
+        HullBuildFace face;
+        face.vertices[0] = a; face.vertices[1] = b; face.vertices[2] = c;
+        face.normal = glm::normalize(glm::cross(points[b] - points[a], points[c] - points[a]));
+        face.offset = glm::dot(face.normal, points[a]);
+        face.alive = true;
+        faces.push_back(face);
+        
+        int index = (int)faces.size() - 1;
+        edgeFaces[HullEdgeKey(a, b)] = index;
+        edgeFaces[HullEdgeKey(b, c)] = index;
+        edgeFaces[HullEdgeKey(c, a)] = index;
+        return index;
+    };
+    
+    if (Orient3D(points[i0], points[i1], points[i2], points[i3]) > 0.0) std::swap(i1, i2);
+    addFace(i0, i1, i2);
+    addFace(i0, i3, i1);
+    addFace(i1, i3, i2);
+    addFace(i2, i3, i0);
+    
+    for (int i = 0; i < (int)points.size(); i++) {
+        if (i == i0 || i == i1 || i == i2 || i == i3) continue;
+        for (HullBuildFace& face : faces) {
+            if (glm::dot(face.normal, points[i]) - face.offset > epsilon) {
+                face.outside.push_back(i);
+                break;
+            }
+        }
+    }
+    
+    std::vector<int> pending = {0, 1, 2, 3};
+    std::vector<int> visible;
+    std::vector<std::pair<int, int>> horizon;
+    std::vector<int> stack;
+    
+    while (!pending.empty()) {
+        
+        int current = pending.back();
+        pending.pop_back();
+        if (!faces[current].alive || faces[current].outside.empty()) continue;
+        
+        int eye = faces[current].outside[0];
+        float eyeDistance = -1.0f;
+        for (int index : faces[current].outside) {
+            float distance = glm::dot(faces[current].normal, points[index]) - faces[current].offset;
+            if (distance > eyeDistance) {
+                eyeDistance = distance;
+                eye = index;
+            }
+        }
+        
+        // Flood the faces visible from the eye point and collect the horizon edges around them. Visibility is
+        // decided exactly, so the visible faces always form a disk and the horizon a single loop, however
+        // close to coplanar the points are; epsilon only decides which points are worth adding.
+        visible.clear();
+        horizon.clear();
+        stack.assign(1, current);
+        faces[current].alive = false;
+        while (!stack.empty()) {
+            int faceIndex = stack.back();
+            stack.pop_back();
+            visible.push_back(faceIndex);
+            
+            for (int edge = 0; edge < 3; edge++) {
+                int a = faces[faceIndex].vertices[edge];
+                int b = faces[faceIndex].vertices[(edge + 1) % 3];
+                
+                auto twin = edgeFaces.find(HullEdgeKey(b, a));
+                if (twin == edgeFaces.end()) continue;
+                
+                HullBuildFace& neighbor = faces[twin->second];
+                if (!neighbor.alive) continue;
+                
+                if (Orient3D(points[neighbor.vertices[0]], points[neighbor.vertices[1]], points[neighbor.vertices[2]], points[eye]) > 0.0) {
+                    neighbor.alive = false;
+                    stack.push_back(twin->second);
+                }
+                else {
+                    horizon.push_back({a, b});
+                }
+            }
+        }
+        
+        for (int faceIndex : visible) {
+            for (int edge = 0; edge < 3; edge++) {
+                auto owner = edgeFaces.find(HullEdgeKey(faces[faceIndex].vertices[edge], faces[faceIndex].vertices[(edge + 1) % 3]));
+                if (owner != edgeFaces.end() && owner->second == faceIndex) edgeFaces.erase(owner);
+            }
+        }
+        
+        int firstNew = (int)faces.size();
+        for (const std::pair<int, int>& edge : horizon) {
+            pending.push_back(addFace(edge.first, edge.second, eye));
+        }
+        
+        for (int faceIndex : visible) {
+            std::vector<int> orphans = std::move(faces[faceIndex].outside);
+            for (int index : orphans) {
+                if (index == eye) continue;
+                for (int newFace = firstNew; newFace < (int)faces.size(); newFace++) {
+                    if (glm::dot(faces[newFace].normal, points[index]) - faces[newFace].offset > epsilon) {
+                        faces[newFace].outside.push_back(index);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    
+    // Compact to the vertices the surviving faces reference
+    std::vector<int> remap(points.size(), -1);
+    for (const HullBuildFace& face : faces) {
+        if (!face.alive) continue;
+        
+        std::array<int, 3> hullFace;
+        for (int i = 0; i < 3; i++) {
+            int index = face.vertices[i];
+            if (remap[index] < 0) {
+                remap[index] = (int)hull.vertices.size();
+                hull.vertices.push_back(points[index]);
+            }
+            hullFace[i] = remap[index];
+        }
+        hull.faces.push_back(hullFace);
+    }
+    return hull;
+}
+
+#endif /* convex_hull_h */
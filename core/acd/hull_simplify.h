@@ -0,0 +1,168 @@
+//
+//  hull_simplify.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-20.
+//
+
+#ifndef hull_simplify_h
+#define hull_simplify_h
+
+#define ACD_MAX_HULL_VERTICES 64
+#define ACD_MAX_HULL_FACES 128
+// The smallest budget SimplifyHull can always meet: the hull's bounding box
+#define ACD_MIN_HULL_VERTICES 8
+#define ACD_MIN_HULL_FACES 12
+
+typedef struct hullPlane {
+    glm::vec3 normal;
+    float area;
+} HullPlane;
+
+typedef struct hullSimplificationReport {
+    float originalVolume;
+    float simplifiedVolume;
+    float maxVolumeError;
+} HullSimplificationReport;
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// ClipHull //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Cuts away everything above dot(normal, P) = offset.
+ConvexHull ClipHull(const ConvexHull& hull, const glm::vec3& normal, float offset, float epsilon) {
+    
+    std::vector<float> heights(hull.vertices.size());
+    bool clipped = false;
+    for (size_t i = 0; i < hull.vertices.size(); i++) {
+        heights[i] = glm::dot(normal, hull.vertices[i]) - offset;
+        clipped = clipped || heights[i] > epsilon;
+    }
+    if (!clipped) return hull;
+    
+    std::vector<glm::vec3> points;
+    for (size_t i = 0; i < hull.vertices.size(); i++) {
+        if (heights[i] <= epsilon) points.push_back(hull.vertices[i]);
+    }
+    for (const std::array<int, 3>& face : hull.faces) {
+        for (int edge = 0; edge < 3; edge++) {
+            int a = face[edge], b = face[(edge + 1) % 3];
+            if ((heights[a] > epsilon) == (heights[b] > epsilon)) continue;
+            
+            float t = heights[a] / (heights[a] - heights[b]);
+            points.push_back(glm::mix(hull.vertices[a], hull.vertices[b], t));
+        }
+    }
+    return BuildConvexHull(points);
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// SimplifyHull //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Rebuilds the hull as the intersection of its most significant face planes, each pushed out until every
+// original vertex is inside, so the result always encloses the cluster. Planes that would push the hull over
+// its vertex or face budget are skipped. The budget is raised to at least ACD_MIN_HULL_VERTICES /
+// ACD_MIN_HULL_FACES, since the bounding box it starts from has to fit. Flat hulls within budget are left
+// alone; over budget they come back as their bounding box, as thin as the polygon allows.
+ConvexHull SimplifyHull(const ConvexHull& hull, int maxVertices, int maxFaces, float skinWidth) {
+    
+    maxVertices = std::max(maxVertices, ACD_MIN_HULL_VERTICES);
+    maxFaces = std::max(maxFaces, ACD_MIN_HULL_FACES);
+    
+    bool withinBudget = (int)hull.vertices.size() <= maxVertices && (int)hull.faces.size() <= maxFaces;
+    if (withinBudget && (skinWidth <= 0.0f || ComputeHullVolume(hull) <= 0.0f)) return hull;
+    
+    // Merge the triangulated faces back into distinct planes
+    std::vector<HullPlane> planes;
+    for (const std::array<int, 3>& face : hull.faces) {
+        const glm::vec3& A = hull.vertices[face[0]];
+        glm::vec3 normal = glm::cross(hull.vertices[face[1]] - A, hull.vertices[face[2]] - A);
+        float area = glm::length(normal) * 0.5f;
+        if (area <= 0.0f) continue;
+        normal /= area * 2.0f;
+        
+        bool merged = false;
+        for (HullPlane& plane : planes) {
+            if (glm::dot(plane.normal, normal) > 0.9995f) {
+                plane.area += area;
+                merged = true;
+                break;
+            }
+        }
+        if (!merged) planes.push_back({normal, area});
+    }
+    
+    // Order by area, discounted by how close each normal is to one already picked, so the first planes
+    // bound the hull from every side instead of crowding around its largest flat region
+    std::vector<HullPlane> ordered;
+    std::vector<float> closeness(planes.size(), -1.0f);
+    std::vector<uint8_t> picked(planes.size(), 0);
+    size_t wanted = std::min(planes.size(), (size_t)std::max(maxFaces, maxVertices) * 4);
+    while (ordered.size() < wanted) {
+        int next = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < planes.size(); i++) {
+            if (picked[i]) continue;
+            float score = planes[i].area * (1.0f - std::max(closeness[i], 0.0f));
+            if (score > bestScore) {
+                bestScore = score;
+                next = (int)i;
+            }
+        }
+        picked[next] = 1;
+        ordered.push_back(planes[next]);
+        for (size_t i = 0; i < planes.size(); i++) {
+            closeness[i] = std::max(closeness[i], glm::dot(planes[i].normal, planes[next].normal));
+        }
+    }
+    planes = std::move(ordered);
+    
+    glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX);
+    for (const glm::vec3& vertex : hull.vertices) {
+        boundsMin = glm::min(boundsMin, vertex);
+        boundsMax = glm::max(boundsMax, vertex);
+    }
+    boundsMin -= glm::vec3(skinWidth);
+    boundsMax += glm::vec3(skinWidth);
+    const float epsilon = glm::length(boundsMax - boundsMin) * 1e-5f;
+    
+    std::vector<glm::vec3> corners;
+    for (int i = 0; i < 8; i++) {
+        corners.push_back(glm::vec3((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z));
+    }
+    ConvexHull box = BuildConvexHull(corners);
+    if (box.vertices.size() < 4) return box;
+    
+    std::vector<float> offsets(planes.size());
+    for (size_t i = 0; i < planes.size(); i++) {
+        offsets[i] = -FLT_MAX;
+        for (const glm::vec3& vertex : hull.vertices) {
+            offsets[i] = std::max(offsets[i], glm::dot(planes[i].normal, vertex));
+        }
+        offsets[i] += skinWidth;
+    }
+    
+    // Starting from the box, add planes in that order as long as the result stays within budget
+    ConvexHull simplified = box;
+    int rejected = 0;
+    for (size_t i = 0; i < planes.size() && rejected < 8; i++) {
+        ConvexHull clipped = ClipHull(simplified, planes[i].normal, offsets[i], epsilon);
+        if (clipped.vertices.size() < 4) continue;
+        
+        if ((int)clipped.vertices.size() <= maxVertices && (int)clipped.faces.size() <= maxFaces) {
+            simplified = std::move(clipped);
+            rejected = 0;
+        }
+        else {
+            rejected++;
+        }
+    }
+    return simplified;
+}
+
+#endif /* hull_simplify_h */
@@ -0,0 +1,382 @@
+//
+//  simplify.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-19.
+//
+
+#ifndef simplify_h
+#define simplify_h
+
+#define ACD_SIMPLIFY_PARTITION_TRIANGLES 65536
+#define ACD_BOUNDARY_WEIGHT 10.0
+
+// Symmetric 4x4 error quadric, stored as its upper triangle.
+typedef struct quadric {
+    double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+} Quadric;
+
+typedef struct collapseCandidate {
+    float cost;
+    uint32_t vertexA, vertexB;
+    uint32_t versionA, versionB;
+    glm::vec3 target;
+    
+    bool operator>(const collapseCandidate& other) const { return cost > other.cost; }
+} CollapseCandidate;
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Quadrics //
+// ------------------------------------------------------------------------------------------------------------- //
+
+Quadric PlaneQuadric(const glm::vec3& normal, const glm::vec3& point, double weight) {
+    
+    double a = normal.x, b = normal.y, c = normal.z;
+    double d = -(a * point.x + b * point.y + c * point.z);
+    
+    return Quadric{
+        weight * a * a, weight * a * b, weight * a * c, weight * a * d,
+        weight * b * b, weight * b * c, weight * b * d,
+        weight * c * c, weight * c * d,
+        weight * d * d
+    };
+}
+
+void AddQuadric(Quadric& target, const Quadric& source) {
+    target.xx += source.xx; target.xy += source.xy; target.xz += source.xz; target.xw += source.xw;
+    target.yy += source.yy; target.yz += source.yz; target.yw += source.yw;
+    target.zz += source.zz; target.zw += source.zw;
+    target.ww += source.ww;
+}
+
+double EvaluateQuadric(const Quadric& q, const glm::vec3& p) {
+    double x = p.x, y = p.y, z = p.z;
+    return q.xx * x * x + 2.0 * q.xy * x * y + 2.0 * q.xz * x * z + 2.0 * q.xw * x
+         + q.yy * y * y + 2.0 * q.yz * y * z + 2.0 * q.yw * y
+         + q.zz * z * z + 2.0 * q.zw * z
+         + q.ww;
+}
+
+// Position minimising the quadric, if the 3x3 system is well conditioned.
+bool SolveQuadric(const Quadric& q, glm::vec3& result) {
+    
+    double det = q.xx * (q.yy * q.zz - q.yz * q.yz)
+               - q.xy * (q.xy * q.zz - q.yz * q.xz)
+               + q.xz * (q.xy * q.yz - q.yy * q.xz);
+    
+    double scale = q.xx + q.yy + q.zz;
+    if (std::fabs(det) <= 1e-9 * scale * scale * scale) return false;
+    
+    double bx = -q.xw, by = -q.yw, bz = -q.zw;
+    double x = (bx * (q.yy * q.zz - q.yz * q.yz) - q.xy * (by * q.zz - q.yz * bz) + q.xz * (by * q.yz - q.yy * bz)) / det;
+    double y = (q.xx * (by * q.zz - q.yz * bz) - bx * (q.xy * q.zz - q.yz * q.xz) + q.xz * (q.xy * bz - by * q.xz)) / det;
+    double z = (q.xx * (q.yy * bz - q.yz * by) - q.xy * (q.xy * bz - by * q.xz) + bx * (q.xy * q.yz - q.yy * q.xz)) / det;
+    
+    result = glm::vec3((float)x, (float)y, (float)z);
+    return true;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// SimplifyTriangles //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Heap-driven edge collapse over a self-contained triangle set. Locked vertices never move, which is what
+// lets partitions of one mesh run side by side. Returns, for every vertex, the vertex it was collapsed into.
+std::vector<uint32_t> SimplifyTriangles(std::vector<glm::vec3>& positions, std::vector<std::array<uint32_t, 3>>& triangles,
+                                        const std::vector<uint8_t>& locked, size_t targetTriangles, double maxCost) {
+    
+    const uint32_t vertexCount = (uint32_t)positions.size();
+    std::vector<uint32_t> collapsedInto(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) collapsedInto[i] = i;
+    
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    std::vector<uint8_t> removed(triangles.size(), 0);
+    std::vector<uint64_t> edges;
+    edges.reserve(triangles.size() * 3);
+    
+    for (uint32_t t = 0; t < triangles.size(); t++) {
+        const std::array<uint32_t, 3>& triangle = triangles[t];
+        glm::vec3 normal = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+        float length = glm::length(normal);
+        
+        for (int i = 0; i < 3; i++) {
+            vertexTriangles[triangle[i]].push_back(t);
+            if (length > 0.0f) AddQuadric(quadrics[triangle[i]], PlaneQuadric(normal / length, positions[triangle[0]], 1.0));
+            
+            uint32_t a = triangle[i], b = triangle[(i + 1) % 3];
+            edges.push_back(((uint64_t)std::min(a, b) << 32) | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    
+    // Open borders get a perpendicular constraint plane so they don't shrink inward
+    for (uint32_t t = 0; t < triangles.size(); t++) {
+        const std::array<uint32_t, 3>& triangle = triangles[t];
+        glm::vec3 normal = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+        
+        for (int i = 0; i < 3; i++) {
+            uint32_t a = triangle[i], b = triangle[(i + 1) % 3];
+            uint64_t key = ((uint64_t)std::min(a, b) << 32) | std::max(a, b);
+            if (std::upper_bound(edges.begin(), edges.end(), key) - std::lower_bound(edges.begin(), edges.end(), key) != 1) continue;
+            
+            glm::vec3 edge = positions[b] - positions[a];
+            glm::vec3 border = glm::cross(edge, normal);
+            float length = glm::length(border);
+            if (length <= 0.0f) continue;
+            
+            Quadric constraint = PlaneQuadric(border / length, positions[a], ACD_BOUNDARY_WEIGHT);
+            AddQuadric(quadrics[a], constraint);
+            AddQuadric(quadrics[b], constraint);
+        }
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    
+    std::vector<uint32_t> versions(vertexCount, 0);
+    
+    auto computeCandidate = [&](uint32_t a, uint32_t b) {
+        CollapseCandidate candidate{0.0f, a, b, versions[a], versions[b], positions[a]};
+        Quadric q = quadrics[a];
+        AddQuadric(q, quadrics[b]);
+        
+        if (locked[a])      candidate.target = positions[a];
+        else if (locked[b]) candidate.target = positions[b];
+        else if (!SolveQuadric(q, candidate.target)) {
+            glm::vec3 options[3] = {positions[a], positions[b], (positions[a] + positions[b]) * 0.5f};
+            double best = DBL_MAX;
+            for (const glm::vec3& option : options) {
+                double error = EvaluateQuadric(q, option);
+                if (error < best) {
+                    best = error;
+                    candidate.target = option;
+                }
+            }
+        }
+        candidate.cost = (float)std::max(EvaluateQuadric(q, candidate.target), 0.0);
+        return candidate;
+    };
+    
+    std::vector<CollapseCandidate> initial;
+    initial.reserve(edges.size());
+    for (uint64_t edge : edges) {
+        uint32_t a = (uint32_t)(edge >> 32), b = (uint32_t)edge;
+        if (locked[a] && locked[b]) continue;
+        initial.push_back(computeCandidate(a, b));
+    }
+    std::priority_queue<CollapseCandidate, std::vector<CollapseCandidate>, std::greater<CollapseCandidate>> queue(std::greater<CollapseCandidate>(), std::move(initial));
+    
+    // Rejects collapses that would flip or fold a surviving triangle
+    auto flips = [&](uint32_t moving, uint32_t other, const glm::vec3& target) {
+        for (uint32_t t : vertexTriangles[moving]) {
+            if (removed[t]) continue;
+            const std::array<uint32_t, 3>& triangle = triangles[t];
+            if (triangle[0] == other || triangle[1] == other || triangle[2] == other) continue;
+            
+            glm::vec3 corners[3] = {positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]};
+            glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            for (int i = 0; i < 3; i++) {
+                if (triangle[i] == moving) corners[i] = target;
+            }
+            glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            if (glm::dot(before, after) <= 0.2f * glm::length(before) * glm::length(after)) return true;
+        }
+        return false;
+    };
+    
+    size_t liveTriangles = triangles.size();
+    std::vector<uint32_t> neighbors;
+    
+    while (liveTriangles > targetTriangles && !queue.empty()) {
+        
+        CollapseCandidate candidate = queue.top();
+        queue.pop();
+        
+        uint32_t keep = candidate.vertexA, gone = candidate.vertexB;
+        if (versions[keep] != candidate.versionA || versions[gone] != candidate.versionB) continue;
+        if (collapsedInto[keep] != keep || collapsedInto[gone] != gone) continue;
+        if (candidate.cost > maxCost) break;
+        if (locked[gone]) std::swap(keep, gone);
+        
+        if (flips(keep, gone, candidate.target) || flips(gone, keep, candidate.target)) continue;
+        
+        positions[keep] = candidate.target;
+        AddQuadric(quadrics[keep], quadrics[gone]);
+        collapsedInto[gone] = keep;
+        versions[keep]++;
+        versions[gone]++;
+        
+        for (uint32_t t : vertexTriangles[gone]) {
+            if (removed[t]) continue;
+            std::array<uint32_t, 3>& triangle = triangles[t];
+            
+            if (triangle[0] == keep || triangle[1] == keep || triangle[2] == keep) {
+                removed[t] = 1;
+                liveTriangles--;
+                continue;
+            }
+            for (int i = 0; i < 3; i++) {
+                if (triangle[i] == gone) triangle[i] = keep;
+            }
+            vertexTriangles[keep].push_back(t);
+        }
+        vertexTriangles[gone].clear();
+        vertexTriangles[gone].shrink_to_fit();
+        
+        std::vector<uint32_t>& around = vertexTriangles[keep];
+        around.erase(std::remove_if(around.begin(), around.end(), [&removed](uint32_t t) { return removed[t] != 0; }), around.end());
+        
+        neighbors.clear();
+        for (uint32_t t : around) {
+            for (int i = 0; i < 3; i++) {
+                if (triangles[t][i] != keep) neighbors.push_back(triangles[t][i]);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        
+        for (uint32_t neighbor : neighbors) {
+            if (locked[keep] && locked[neighbor]) continue;
+            queue.push(computeCandidate(keep, neighbor));
+        }
+    }
+    
+    size_t write = 0;
+    for (size_t t = 0; t < triangles.size(); t++) {
+        if (!removed[t]) triangles[write++] = triangles[t];
+    }
+    triangles.resize(write);
+    
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        uint32_t root = i;
+        while (collapsedInto[root] != root) root = collapsedInto[root];
+        collapsedInto[i] = root;
+    }
+    return collapsedInto;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// SimplifyMesh //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Decimates an 8-float-per-vertex mesh down to targetTriangles, stopping early once a collapse would move the
+// surface by more than maxError. Large meshes are cut into slabs along their longest axis and each slab is
+// simplified on the thread pool with its shared border locked, then the border is cleaned up in a final pass.
+Mesh SimplifyMesh(const Mesh& mesh, size_t targetTriangles, float maxError) {
+    
+    std::vector<glm::vec3> positions = GetMeshPositions(mesh);
+    std::vector<std::array<uint32_t, 3>> triangles(mesh.indices.size() / 3);
+    for (size_t i = 0; i < triangles.size(); i++) {
+        triangles[i] = {mesh.indices[i * 3], mesh.indices[i * 3 + 1], mesh.indices[i * 3 + 2]};
+    }
+    if (triangles.size() <= targetTriangles) return mesh;
+    
+    double maxCost = maxError == FLT_MAX ? DBL_MAX : (double)maxError * maxError;
+    
+    size_t partitions = triangles.size() > ACD_SIMPLIFY_PARTITION_TRIANGLES ? std::max<size_t>(threadPool.Size(), 1) : 1;
+    partitions = std::min(partitions, triangles.size() / (ACD_SIMPLIFY_PARTITION_TRIANGLES / 4) + 1);
+    
+    if (partitions > 1) {
+        glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX);
+        for (const glm::vec3& P : positions) {
+            boundsMin = glm::min(boundsMin, P);
+            boundsMax = glm::max(boundsMax, P);
+        }
+        glm::vec3 extent = boundsMax - boundsMin;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        
+        std::sort(triangles.begin(), triangles.end(), [&positions, axis](const std::array<uint32_t, 3>& A, const std::array<uint32_t, 3>& B) {
+            return positions[A[0]][axis] + positions[A[1]][axis] + positions[A[2]][axis] < positions[B[0]][axis] + positions[B[1]][axis] + positions[B[2]][axis];
+        });
+        
+        // A vertex used by more than one slab is on a seam and must stay put
+        const uint32_t shared = UINT32_MAX;
+        std::vector<uint32_t> owner(positions.size(), UINT32_MAX - 1);
+        size_t slabSize = (triangles.size() + partitions - 1) / partitions;
+        for (size_t t = 0; t < triangles.size(); t++) {
+            uint32_t slab = (uint32_t)(t / slabSize);
+            for (uint32_t index : triangles[t]) {
+                if (owner[index] == UINT32_MAX - 1) owner[index] = slab;
+                else if (owner[index] != slab)      owner[index] = shared;
+            }
+        }
+        
+        std::vector<std::vector<std::array<uint32_t, 3>>> results(partitions);
+        threadPool.ParallelFor(partitions, 1, [&](size_t begin, size_t end) {
+            for (size_t slab = begin; slab < end; slab++) {
+                
+                size_t first = slab * slabSize, last = std::min(first + slabSize, triangles.size());
+                if (first >= last) continue;
+                
+                std::unordered_map<uint32_t, uint32_t> toLocal;
+                std::vector<uint32_t> toGlobal;
+                std::vector<glm::vec3> localPositions;
+                std::vector<uint8_t> localLocked;
+                std::vector<std::array<uint32_t, 3>> localTriangles;
+                localTriangles.reserve(last - first);
+                
+                for (size_t t = first; t < last; t++) {
+                    std::array<uint32_t, 3> local;
+                    for (int i = 0; i < 3; i++) {
+                        auto found = toLocal.find(triangles[t][i]);
+                        if (found == toLocal.end()) {
+                            found = toLocal.emplace(triangles[t][i], (uint32_t)toGlobal.size()).first;
+                            toGlobal.push_back(triangles[t][i]);
+                            localPositions.push_back(positions[triangles[t][i]]);
+                            localLocked.push_back(owner[triangles[t][i]] == shared);
+                        }
+                        local[i] = found->second;
+                    }
+                    localTriangles.push_back(local);
+                }
+                
+                size_t localTarget = targetTriangles * (last - first) / triangles.size();
+                SimplifyTriangles(localPositions, localTriangles, localLocked, localTarget, maxCost);
+                
+                // Only this slab's own vertices can have moved, so writing them back does not race
+                for (size_t i = 0; i < toGlobal.size(); i++) {
+                    if (!localLocked[i]) positions[toGlobal[i]] = localPositions[i];
+                }
+                for (std::array<uint32_t, 3>& triangle : localTriangles) {
+                    results[slab].push_back({toGlobal[triangle[0]], toGlobal[triangle[1]], toGlobal[triangle[2]]});
+                }
+            }
+        });
+        
+        triangles.clear();
+        for (const std::vector<std::array<uint32_t, 3>>& result : results) {
+            triangles.insert(triangles.end(), result.begin(), result.end());
+        }
+    }
+    
+    if (triangles.size() > targetTriangles) {
+        std::vector<uint8_t> unlocked(positions.size(), 0);
+        SimplifyTriangles(positions, triangles, unlocked, targetTriangles, maxCost);
+    }
+    
+    // Compact to the surviving vertices, keeping each one's normal and uv
+    Mesh simplified{};
+    simplified.color = mesh.color;
+    std::vector<uint32_t> remap(positions.size(), UINT32_MAX);
+    for (const std::array<uint32_t, 3>& triangle : triangles) {
+        for (uint32_t index : triangle) {
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = (uint32_t)MeshLayout::Count(simplified.vertices);
+                const float* source = &mesh.vertices[index * MeshLayout::stride];
+                simplified.vertices.insert(simplified.vertices.end(), source, source + MeshLayout::stride);
+                
+                float* position = &simplified.vertices[remap[index] * MeshLayout::stride + MeshLayout::Offset<PositionAttribute>()];
+                position[0] = positions[index].x; position[1] = positions[index].y; position[2] = positions[index].z;
+            }
+            simplified.indices.push_back(remap[index]);
+        }
+    }
+    return simplified;
+}
+
+#endif /* simplify_h */
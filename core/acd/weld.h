@@ -0,0 +1,252 @@
+//
+//  weld.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef weld_h
+#define weld_h
+
+#include <cfloat>
+
+#define ACD_WELD_TOLERANCE 1e-5f
+#define ACD_WELD_CELL_SCALE 8.0f
+#define ACD_WELD_SHARDS 64
+
+// A grid cell of the weld hash and the first representative vertex inside it. Representatives in the
+// same cell are chained through WeldGrid::nextRepresentative.
+typedef struct weldCell {
+    uint64_t key;
+    int32_t head;
+} WeldCell;
+
+typedef struct weldGrid {
+    glm::vec3 origin;
+    float cellSize;
+    std::vector<std::vector<WeldCell>> shards;
+    std::vector<int32_t> nextRepresentative;
+} WeldGrid;
+
+inline uint64_t HashWeldCell(uint64_t key) {
+    
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    return key ^ (key >> 33);
+}
+
+// Cell coordinates are offset by one so the neighbours of cell 0 still have a valid key.
+inline uint64_t WeldCellKey(int64_t x, int64_t y, int64_t z) {
+    return (uint64_t)(x + 1) | ((uint64_t)(y + 1) << 21) | ((uint64_t)(z + 1) << 42);
+}
+
+int32_t FindWeldCell(const WeldGrid& grid, uint64_t key) {
+    
+    uint64_t hash = HashWeldCell(key);
+    const std::vector<WeldCell>& table = grid.shards[hash % ACD_WELD_SHARDS];
+    size_t mask = table.size() - 1;
+    for (size_t slot = (hash / ACD_WELD_SHARDS) & mask;; slot = (slot + 1) & mask) {
+        if (table[slot].head < 0) return -1;
+        if (table[slot].key == key) return table[slot].head;
+    }
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// WeldMesh //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Merges vertices closer than tolerance (relative to the bounding box diagonal) and returns an indexed
+// mesh. A mesh without indices is read as a triangle soup, three vertices per triangle. The surviving
+// vertex keeps the attributes of the lowest-numbered vertex it absorbed; triangles that collapse are
+// dropped.
+//
+// Vertices are hashed into a grid with cells ACD_WELD_CELL_SCALE times the tolerance, sharded by cell
+// so every shard is built on its own thread. Each cell keeps the distinct positions (representatives)
+// found inside it. Only a representative lying within tolerance of a cell face has to look across it,
+// which with these cells is a small fraction of them, and it moves to the lowest-numbered
+// representative in reach. Chains of such moves always go downward, so they are short and resolve
+// without locking.
+Mesh WeldMesh(const Mesh& mesh, float tolerance = ACD_WELD_TOLERANCE) {
+    
+    size_t vertexCount = MeshLayout::Count(mesh.vertices);
+    if (vertexCount == 0) return mesh;
+    const size_t grainSize = 1 << 16;
+    size_t chunkCount = (vertexCount + grainSize - 1) / grainSize;
+    
+    // Step 1: Bounds, which set the absolute tolerance and the grid origin
+    std::vector<glm::vec3> chunkMin(chunkCount, glm::vec3(FLT_MAX)), chunkMax(chunkCount, glm::vec3(-FLT_MAX));
+    threadPool.ParallelFor(vertexCount, grainSize, [&](size_t begin, size_t end) {
+        glm::vec3& low = chunkMin[begin / grainSize];
+        glm::vec3& high = chunkMax[begin / grainSize];
+        for (size_t v = begin; v < end; v++) {
+            glm::vec3 p = MeshLayout::Position(mesh.vertices.data(), v);
+            low = glm::min(low, p);
+            high = glm::max(high, p);
+        }
+    });
+    glm::vec3 boundsMin = chunkMin[0], boundsMax = chunkMax[0];
+    for (size_t i = 1; i < chunkCount; i++) {
+        boundsMin = glm::min(boundsMin, chunkMin[i]);
+        boundsMax = glm::max(boundsMax, chunkMax[i]);
+    }
+    float diagonal = glm::length(boundsMax - boundsMin);
+    float distance = std::max(tolerance * diagonal, 1e-30f);
+    float distanceSquared = distance * distance;
+    
+    WeldGrid grid;
+    grid.origin = boundsMin;
+    grid.cellSize = std::max(distance * ACD_WELD_CELL_SCALE, diagonal / (float)(1 << 20));
+    grid.shards.resize(ACD_WELD_SHARDS);
+    grid.nextRepresentative.assign(vertexCount, -1);
+    
+    auto position = [&](uint32_t v) {
+        return MeshLayout::Position(mesh.vertices.data(), v);
+    };
+    auto cellOf = [&](const glm::vec3& p) {
+        glm::vec3 cell = glm::floor((p - grid.origin) / grid.cellSize);
+        return glm::ivec3((int)cell.x, (int)cell.y, (int)cell.z);
+    };
+    
+    // Step 2: Bucket the vertices by shard, keeping vertex order inside every bucket
+    std::vector<std::vector<std::vector<uint32_t>>> buckets(chunkCount, std::vector<std::vector<uint32_t>>(ACD_WELD_SHARDS));
+    threadPool.ParallelFor(vertexCount, grainSize, [&](size_t begin, size_t end) {
+        std::vector<std::vector<uint32_t>>& shards = buckets[begin / grainSize];
+        for (size_t v = begin; v < end; v++) {
+            glm::ivec3 cell = cellOf(position((uint32_t)v));
+            shards[HashWeldCell(WeldCellKey(cell.x, cell.y, cell.z)) % ACD_WELD_SHARDS].push_back((uint32_t)v);
+        }
+    });
+    
+    // Step 3: Every shard finds the representatives of its own cells
+    std::vector<uint32_t> representative(vertexCount);
+    threadPool.ParallelFor(ACD_WELD_SHARDS, 1, [&](size_t begin, size_t end) {
+        for (size_t shard = begin; shard < end; shard++) {
+            size_t count = 0;
+            for (const auto& shards : buckets) count += shards[shard].size();
+            
+            size_t capacity = 16;
+            while (capacity < count * 2) capacity <<= 1;
+            std::vector<WeldCell>& table = grid.shards[shard];
+            table.assign(capacity, WeldCell{0, -1});
+            
+            for (const auto& shards : buckets) {
+                for (uint32_t v : shards[shard]) {
+                    glm::vec3 p = position(v);
+                    glm::ivec3 cell = cellOf(p);
+                    uint64_t key = WeldCellKey(cell.x, cell.y, cell.z);
+                    
+                    size_t slot = (HashWeldCell(key) / ACD_WELD_SHARDS) & (capacity - 1);
+                    while (table[slot].head >= 0 && table[slot].key != key) slot = (slot + 1) & (capacity - 1);
+                    
+                    // Representatives are chained newest first; the oldest one in reach wins
+                    int32_t found = -1;
+                    for (int32_t r = table[slot].head; r >= 0; r = grid.nextRepresentative[r]) {
+                        glm::vec3 offset = position(r) - p;
+                        if (glm::dot(offset, offset) <= distanceSquared) found = r;
+                    }
+                    if (found >= 0) {
+                        representative[v] = (uint32_t)found;
+                        continue;
+                    }
+                    representative[v] = v;
+                    grid.nextRepresentative[v] = table[slot].head;
+                    table[slot] = WeldCell{key, (int32_t)v};
+                }
+            }
+        }
+    });
+    buckets.clear();
+    
+    // Step 4: Representatives near a cell face look for an older representative across it
+    std::vector<uint32_t> target(vertexCount);
+    threadPool.ParallelFor(vertexCount, grainSize, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            target[v] = (uint32_t)v;
+            if (representative[v] != v) continue;
+            
+            glm::vec3 p = position((uint32_t)v);
+            glm::vec3 local = (p - grid.origin) / grid.cellSize;
+            glm::ivec3 cell = cellOf(p);
+            glm::ivec3 low, high;
+            for (int axis = 0; axis < 3; axis++) {
+                float fraction = local[axis] - (float)cell[axis];
+                low[axis] = fraction * grid.cellSize <= distance ? -1 : 0;
+                high[axis] = (1.0f - fraction) * grid.cellSize <= distance ? 1 : 0;
+            }
+            if (low == glm::ivec3(0, 0, 0) && high == glm::ivec3(0, 0, 0)) continue;
+            
+            for (int dx = low.x; dx <= high.x; dx++) {
+                for (int dy = low.y; dy <= high.y; dy++) {
+                    for (int dz = low.z; dz <= high.z; dz++) {
+                        if (dx == 0 && dy == 0 && dz == 0) continue;
+                        for (int32_t r = FindWeldCell(grid, WeldCellKey(cell.x + dx, cell.y + dy, cell.z + dz)); r >= 0; r = grid.nextRepresentative[r]) {
+                            glm::vec3 offset = position(r) - p;
+                            if ((uint32_t)r < target[v] && glm::dot(offset, offset) <= distanceSquared) target[v] = (uint32_t)r;
+                        }
+                    }
+                }
+            }
+        }
+    });
+    
+    // Step 5: Resolve every vertex to its final survivor and number the survivors in vertex order
+    std::vector<uint32_t> chunkSurvivors(chunkCount, 0);
+    threadPool.ParallelFor(vertexCount, grainSize, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            uint32_t survivor = representative[v];
+            while (target[survivor] != survivor) survivor = target[survivor];
+            representative[v] = survivor;
+            chunkSurvivors[begin / grainSize] += survivor == v;
+        }
+    });
+    
+    std::vector<size_t> chunkOffsets(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; i++) {
+        chunkOffsets[i + 1] = chunkOffsets[i] + chunkSurvivors[i];
+    }
+    
+    Mesh welded{};
+    welded.vertices.resize(chunkOffsets[chunkCount] * MeshLayout::stride);
+    std::vector<uint32_t>& newIndex = target;
+    threadPool.ParallelFor(vertexCount, grainSize, [&](size_t begin, size_t end) {
+        size_t next = chunkOffsets[begin / grainSize];
+        for (size_t v = begin; v < end; v++) {
+            if (representative[v] != v) continue;
+            const float* source = &mesh.vertices[v * MeshLayout::stride];
+            std::copy(source, source + MeshLayout::stride, &welded.vertices[next * MeshLayout::stride]);
+            newIndex[v] = (uint32_t)next++;
+        }
+    });
+    
+    // Step 6: Rewrite the triangles, dropping the ones that collapsed
+    bool soup = mesh.indices.empty();
+    size_t triangleCount = soup ? vertexCount / 3 : mesh.indices.size() / 3;
+    size_t triangleChunks = (triangleCount + grainSize - 1) / grainSize;
+    std::vector<std::vector<uint32_t>> chunkIndices(triangleChunks);
+    
+    threadPool.ParallelFor(triangleCount, grainSize, [&](size_t begin, size_t end) {
+        std::vector<uint32_t>& indices = chunkIndices[begin / grainSize];
+        indices.reserve((end - begin) * 3);
+        for (size_t t = begin; t < end; t++) {
+            uint32_t corners[3];
+            for (int i = 0; i < 3; i++) {
+                uint32_t source = soup ? (uint32_t)(t * 3 + i) : mesh.indices[t * 3 + i];
+                corners[i] = newIndex[representative[source]];
+            }
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2]) continue;
+            indices.insert(indices.end(), corners, corners + 3);
+        }
+    });
+    
+    for (const std::vector<uint32_t>& indices : chunkIndices) {
+        welded.indices.insert(welded.indices.end(), indices.begin(), indices.end());
+    }
+    welded.color = mesh.color;
+    return welded;
+}
+
+#endif /* weld_h */
@@ -0,0 +1,344 @@
+//
+//  aabb_tree.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-21.
+//
+
+#ifndef aabb_tree_h
+#define aabb_tree_h
+
+#define AABB_TREE_NULL -1
+
+typedef struct aabb {
+    glm::vec3 min, max;
+} AABB;
+
+typedef struct aabbTreeNode {
+    AABB box;
+    int parent;
+    int child1, child2;
+    int height;
+    int data;
+} AABBTreeNode;
+
+inline AABB CombineAABB(const AABB& A, const AABB& B) {
+    return AABB{glm::min(A.min, B.min), glm::max(A.max, B.max)};
+}
+
+inline float AABBSurfaceArea(const AABB& box) {
+    glm::vec3 size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+inline bool AABBOverlaps(const AABB& A, const AABB& B) {
+    return A.min.x <= B.max.x && A.max.x >= B.min.x &&
+           A.min.y <= B.max.y && A.max.y >= B.min.y &&
+           A.min.z <= B.max.z && A.max.z >= B.min.z;
+}
+
+inline bool AABBContains(const AABB& outer, const AABB& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+// Slab test; inverseDirection components may be infinite for axis-aligned rays.
+inline bool RayOverlapsAABB(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+    
+    float enter = 0.0f, exit = maxDistance;
+    for (int axis = 0; axis < 3; axis++) {
+        float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+        float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t1 != t1 || t2 != t2) continue;
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+    }
+    return enter <= exit;
+}
+
+// Bounding box of a local box under an affine transform, from its transformed center and extent.
+inline AABB TransformAABB(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& transform) {
+    
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+    glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+    glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x +
+                            glm::abs(glm::vec3(transform[1])) * extent.y +
+                            glm::abs(glm::vec3(transform[2])) * extent.z;
+    return AABB{worldCenter - worldExtent, worldCenter + worldExtent};
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// AABBTree //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Dynamic bounding volume tree over fat boxes. Leaves are placed by the surface-area heuristic and the
+// path back to the root is kept height balanced with rotations, so moving leaves never degrades it.
+class AABBTree {
+public:
+    int CreateProxy(const AABB& box, int data);
+    void DestroyProxy(int proxy);
+    bool MoveProxy(int proxy, const AABB& box, const glm::vec3& displacement, float margin);
+    
+    const AABB& GetFatAABB(int proxy) const { return nodes[proxy].box; }
+    int GetData(int proxy) const { return nodes[proxy].data; }
+    int GetHeight() const { return root == AABB_TREE_NULL ? 0 : nodes[root].height; }
+    
+    template<typename Callback> void Query(const AABB& box, Callback callback) const;
+    template<typename Callback> void Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback callback) const;
+    
+private:
+    std::vector<AABBTreeNode> nodes;
+    int root = AABB_TREE_NULL;
+    int freeList = AABB_TREE_NULL;
+    
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    void Refit(int node);
+    int Balance(int node);
+    bool IsLeaf(int node) const { return nodes[node].child1 == AABB_TREE_NULL; }
+};
+
+int AABBTree::AllocateNode() {
+    
+    if (freeList == AABB_TREE_NULL) {
+        nodes.push_back(AABBTreeNode{});
+        freeList = (int)nodes.size() - 1;
+        nodes[freeList].parent = AABB_TREE_NULL;
+    }
+    int node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = AABBTreeNode{AABB{}, AABB_TREE_NULL, AABB_TREE_NULL, AABB_TREE_NULL, 0, -1};
+    return node;
+}
+
+void AABBTree::FreeNode(int node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int AABBTree::CreateProxy(const AABB& box, int data) {
+    
+    int proxy = AllocateNode();
+    nodes[proxy].box = box;
+    nodes[proxy].data = data;
+    InsertLeaf(proxy);
+    return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy) {
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+}
+
+// Only reinserts when the tight box has left its fat box. The new fat box is grown by margin and stretched
+// along the displacement so a steadily moving leaf stays put for several updates.
+bool AABBTree::MoveProxy(int proxy, const AABB& box, const glm::vec3& displacement, float margin) {
+    
+    if (AABBContains(nodes[proxy].box, box)) return false;
+    
+    RemoveLeaf(proxy);
+    
+    AABB fat{box.min - glm::vec3(margin), box.max + glm::vec3(margin)};
+    glm::vec3 stretch = displacement * 2.0f;
+    fat.min += glm::min(stretch, glm::vec3(0.0f));
+    fat.max += glm::max(stretch, glm::vec3(0.0f));
+    nodes[proxy].box = fat;
+    
+    InsertLeaf(proxy);
+    return true;
+}
+
+void AABBTree::InsertLeaf(int leaf) {
+    
+    if (root == AABB_TREE_NULL) {
+        root = leaf;
+        nodes[root].parent = AABB_TREE_NULL;
+        return;
+    }
+    
+    // Descend toward the sibling that makes the cheapest new parent
+    AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!IsLeaf(index)) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        
+        float area = AABBSurfaceArea(nodes[index].box);
+        float combinedArea = AABBSurfaceArea(CombineAABB(nodes[index].box, leafBox));
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+        
+        auto descendCost = [&](int child) {
+            float enlarged = AABBSurfaceArea(CombineAABB(leafBox, nodes[child].box));
+            return IsLeaf(child) ? enlarged + inheritanceCost : enlarged - AABBSurfaceArea(nodes[child].box) + inheritanceCost;
+        };
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+        
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? child1 : child2;
+    }
+    
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = CombineAABB(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+    
+    if (oldParent != AABB_TREE_NULL) {
+        if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else                                    nodes[oldParent].child2 = newParent;
+    }
+    else {
+        root = newParent;
+    }
+    Refit(newParent);
+}
+
+void AABBTree::RemoveLeaf(int leaf) {
+    
+    if (leaf == root) {
+        root = AABB_TREE_NULL;
+        return;
+    }
+    
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    
+    if (grandParent != AABB_TREE_NULL) {
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else                                     nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+        Refit(grandParent);
+    }
+    else {
+        root = sibling;
+        nodes[sibling].parent = AABB_TREE_NULL;
+        FreeNode(parent);
+    }
+}
+
+// Walks back to the root rebalancing and refitting every ancestor.
+void AABBTree::Refit(int node) {
+    
+    while (node != AABB_TREE_NULL) {
+        node = Balance(node);
+        
+        int child1 = nodes[node].child1;
+        int child2 = nodes[node].child2;
+        nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[node].box = CombineAABB(nodes[child1].box, nodes[child2].box);
+        
+        node = nodes[node].parent;
+    }
+}
+
+// If one child of A is more than one level taller than the other, rotates that child up into A's place
+// and hands its shorter grandchild down to A. Returns the node now at A's position.
+int AABBTree::Balance(int iA) {
+    
+    if (IsLeaf(iA) || nodes[iA].height < 2) return iA;
+    
+    int iB = nodes[iA].child1;
+    int iC = nodes[iA].child2;
+    int balance = nodes[iC].height - nodes[iB].height;
+    if (balance >= -1 && balance <= 1) return iA;
+    
+    // Rotate the taller child (iUp) up; iStay is the child that remains under A
+    int iUp = balance > 1 ? iC : iB;
+    int iStay = balance > 1 ? iB : iC;
+    int iF = nodes[iUp].child1;
+    int iG = nodes[iUp].child2;
+    
+    nodes[iUp].child1 = iA;
+    nodes[iUp].parent = nodes[iA].parent;
+    nodes[iA].parent = iUp;
+    
+    int upParent = nodes[iUp].parent;
+    if (upParent != AABB_TREE_NULL) {
+        if (nodes[upParent].child1 == iA) nodes[upParent].child1 = iUp;
+        else                              nodes[upParent].child2 = iUp;
+    }
+    else {
+        root = iUp;
+    }
+    
+    // The taller grandchild stays with iUp, the shorter one moves under A
+    int iKeep = nodes[iF].height > nodes[iG].height ? iF : iG;
+    int iMove = iKeep == iF ? iG : iF;
+    nodes[iUp].child2 = iKeep;
+    if (balance > 1) nodes[iA].child2 = iMove;
+    else             nodes[iA].child1 = iMove;
+    nodes[iMove].parent = iA;
+    
+    nodes[iA].box = CombineAABB(nodes[iStay].box, nodes[iMove].box);
+    nodes[iA].height = 1 + std::max(nodes[iStay].height, nodes[iMove].height);
+    nodes[iUp].box = CombineAABB(nodes[iA].box, nodes[iKeep].box);
+    nodes[iUp].height = 1 + std::max(nodes[iA].height, nodes[iKeep].height);
+    return iUp;
+}
+
+// callback(proxy) is called for every leaf whose fat box overlaps box; returning false stops the query.
+template<typename Callback>
+void AABBTree::Query(const AABB& box, Callback callback) const {
+    
+    if (root == AABB_TREE_NULL) return;
+    
+    int stack[256];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0) {
+        int node = stack[--count];
+        if (!AABBOverlaps(nodes[node].box, box)) continue;
+        
+        if (IsLeaf(node)) {
+            if (!callback(node)) return;
+        }
+        else if (count + 2 <= 256) {
+            stack[count++] = nodes[node].child1;
+            stack[count++] = nodes[node].child2;
+        }
+    }
+}
+
+// callback(proxy, maxDistance) returns the hit distance along the ray, or a negative value for a miss.
+// Hits shrink the ray so later subtrees beyond the nearest hit are skipped.
+template<typename Callback>
+void AABBTree::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback callback) const {
+    
+    if (root == AABB_TREE_NULL) return;
+    
+    glm::vec3 inverseDirection = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    
+    int stack[256];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0) {
+        int node = stack[--count];
+        if (!RayOverlapsAABB(nodes[node].box, origin, inverseDirection, maxDistance)) continue;
+        
+        if (IsLeaf(node)) {
+            float distance = callback(node, maxDistance);
+            if (distance >= 0.0f && distance < maxDistance) maxDistance = distance;
+        }
+        else if (count + 2 <= 256) {
+            stack[count++] = nodes[node].child1;
+            stack[count++] = nodes[node].child2;
+        }
+    }
+}
+
+#endif /* aabb_tree_h */
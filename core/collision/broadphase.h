@@ -0,0 +1,236 @@
+//
+//  broadphase.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-21.
+//
+
+#ifndef broadphase_h
+#define broadphase_h
+
+#define BROADPHASE_FAT_MARGIN 0.1f
+
+typedef struct broadphaseProxy {
+    RObject* object;
+    int piece;
+    int node;
+    AABB box;
+} BroadphaseProxy;
+
+typedef struct broadphaseObject {
+    std::vector<int> proxies;
+    glm::mat4 transform;
+    glm::mat4 inverseTransform;
+} BroadphaseObject;
+
+typedef struct broadphaseHit {
+    RObject* object;
+    int piece;
+    Intersection intersection;
+} BroadphaseHit;
+
+// Every convex piece of every registered object lives in one AABB tree in world space. Update pulls the
+// transforms from CreateModelMatrix; FindPairs produces the candidate pairs for NarrowPhase.
+class Broadphase {
+public:
+    void Add(RObject* object);
+    void Remove(RObject* object);
+    int Update();
+    
+    std::vector<CollisionQuery> FindPairs() const;
+    std::optional<BroadphaseHit> Raycast(const Ray& ray, float maxDistance) const;
+    
+    int GetTreeHeight() const { return tree.GetHeight(); }
+    
+private:
+    AABBTree tree;
+    std::vector<BroadphaseProxy> proxies;
+    std::vector<int> freeProxies;
+    std::unordered_map<RObject*, BroadphaseObject> objects;
+    
+    float HullRaycast(const BroadphaseProxy& proxy, const Ray& ray, float maxDistance, glm::vec3& normal) const;
+};
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Add / Remove //
+// ------------------------------------------------------------------------------------------------------------- //
+
+void Broadphase::Add(RObject* object) {
+    
+    if (objects.count(object)) Remove(object);
+    
+    BroadphaseObject& entry = objects[object];
+    entry.transform = object->CreateModelMatrix();
+    entry.inverseTransform = glm::inverse(entry.transform);
+    
+    for (int piece = 0; piece < (int)object->GetCollisionHulls().size(); piece++) {
+        const CollisionHull& hull = object->GetCollisionHulls()[piece];
+        AABB box = TransformAABB(hull.boundsMin, hull.boundsMax, entry.transform);
+        float margin = BROADPHASE_FAT_MARGIN * glm::length(box.max - box.min);
+        
+        int index;
+        if (!freeProxies.empty()) {
+            index = freeProxies.back();
+            freeProxies.pop_back();
+        }
+        else {
+            index = (int)proxies.size();
+            proxies.push_back({});
+        }
+        proxies[index] = BroadphaseProxy{object, piece, tree.CreateProxy(AABB{box.min - glm::vec3(margin), box.max + glm::vec3(margin)}, index), box};
+        entry.proxies.push_back(index);
+    }
+}
+
+void Broadphase::Remove(RObject* object) {
+    
+    auto entry = objects.find(object);
+    if (entry == objects.end()) return;
+    
+    for (int index : entry->second.proxies) {
+        tree.DestroyProxy(proxies[index].node);
+        proxies[index].object = nullptr;
+        freeProxies.push_back(index);
+    }
+    objects.erase(entry);
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Update //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Recomputes every piece's world box in parallel, then moves the tree leaves whose fat box no longer
+// contains it. Returns the number of leaves that had to be reinserted.
+int Broadphase::Update() {
+    
+    // Objects whose decomposition was swapped out since the last update get their proxies rebuilt
+    std::vector<RObject*> changed;
+    for (auto& [object, entry] : objects) {
+        if (entry.proxies.size() != object->GetCollisionHulls().size()) changed.push_back(object);
+    }
+    for (RObject* object : changed) {
+        Add(object);
+    }
+    
+    std::vector<BroadphaseObject*> entries;
+    std::vector<RObject*> owners;
+    for (auto& [object, entry] : objects) {
+        entry.transform = object->CreateModelMatrix();
+        entries.push_back(&entry);
+        owners.push_back(object);
+    }
+    
+    std::vector<AABB> previous(proxies.size());
+    threadPool.ParallelFor(entries.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            BroadphaseObject& entry = *entries[i];
+            entry.inverseTransform = glm::inverse(entry.transform);
+            for (int index : entry.proxies) {
+                BroadphaseProxy& proxy = proxies[index];
+                const CollisionHull& hull = owners[i]->GetCollisionHulls()[proxy.piece];
+                previous[index] = proxy.box;
+                proxy.box = TransformAABB(hull.boundsMin, hull.boundsMax, entry.transform);
+            }
+        }
+    });
+    
+    int moved = 0;
+    for (size_t index = 0; index < proxies.size(); index++) {
+        BroadphaseProxy& proxy = proxies[index];
+        if (!proxy.object) continue;
+        
+        glm::vec3 displacement = (proxy.box.min + proxy.box.max - previous[index].min - previous[index].max) * 0.5f;
+        float margin = BROADPHASE_FAT_MARGIN * glm::length(proxy.box.max - proxy.box.min);
+        moved += tree.MoveProxy(proxy.node, proxy.box, displacement, margin);
+    }
+    return moved;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// FindPairs //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Pairs of pieces from different objects whose tight world boxes overlap. Each proxy queries the tree on
+// its own, so the work splits cleanly over the thread pool; a pair is reported by its lower proxy only.
+std::vector<CollisionQuery> Broadphase::FindPairs() const {
+    
+    const size_t grainSize = 256;
+    size_t chunkCount = (proxies.size() + grainSize - 1) / grainSize;
+    std::vector<std::vector<CollisionQuery>> chunks(chunkCount);
+    
+    threadPool.ParallelFor(proxies.size(), grainSize, [&](size_t begin, size_t end) {
+        std::vector<CollisionQuery>& pairs = chunks[begin / grainSize];
+        for (size_t index = begin; index < end; index++) {
+            const BroadphaseProxy& proxy = proxies[index];
+            if (!proxy.object) continue;
+            
+            tree.Query(proxy.box, [&](int node) {
+                const BroadphaseProxy& other = proxies[tree.GetData(node)];
+                if ((size_t)tree.GetData(node) > index && other.object != proxy.object && AABBOverlaps(proxy.box, other.box)) {
+                    pairs.push_back({proxy.object, proxy.piece, other.object, other.piece});
+                }
+                return true;
+            });
+        }
+    });
+    
+    std::vector<CollisionQuery> pairs;
+    for (const std::vector<CollisionQuery>& chunk : chunks) {
+        pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+    }
+    return pairs;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Raycast //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Clips the ray against the piece's planes in the object's hull blob, in its local space. Affine maps keep
+// the ray parameter, so the distance needs no conversion back to world space.
+float Broadphase::HullRaycast(const BroadphaseProxy& proxy, const Ray& ray, float maxDistance, glm::vec3& normal) const {
+    
+    const BroadphaseObject& entry = objects.at(proxy.object);
+    const HullBlob& blob = proxy.object->GetHullBlob();
+    
+    glm::vec3 origin = glm::vec3(entry.inverseTransform * glm::vec4(ray.origin, 1.0f));
+    glm::vec3 direction = glm::mat3(entry.inverseTransform) * ray.direction;
+    
+    int enterPlane;
+    float enter = blob.Raycast(proxy.piece, origin, direction, maxDistance, enterPlane);
+    if (enter < 0.0f) return -1.0f;
+    
+    if (enterPlane < 0) {
+        normal = -ray.direction;
+    }
+    else {
+        glm::vec3 localNormal = glm::vec3(blob.GetPlane(proxy.piece, enterPlane));
+        normal = glm::normalize(glm::transpose(glm::mat3(entry.inverseTransform)) * localNormal);
+    }
+    return enter;
+}
+
+std::optional<BroadphaseHit> Broadphase::Raycast(const Ray& ray, float maxDistance) const {
+    
+    std::optional<BroadphaseHit> closest;
+    tree.Raycast(ray.origin, ray.direction, maxDistance, [&](int node, float currentMax) {
+        const BroadphaseProxy& proxy = proxies[tree.GetData(node)];
+        
+        glm::vec3 normal;
+        float distance = HullRaycast(proxy, ray, currentMax, normal);
+        if (distance >= 0.0f && (!closest || distance < closest->intersection.distance)) {
+            closest = BroadphaseHit{proxy.object, proxy.piece, Intersection{ray.origin + ray.direction * distance, normal, distance}};
+        }
+        return distance;
+    });
+    return closest;
+}
+
+#endif /* broadphase_h */
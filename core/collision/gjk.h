@@ -0,0 +1,511 @@
+//
+//  gjk.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-21.
+//
+
+#ifndef gjk_h
+#define gjk_h
+
+#define GJK_MAX_ITERATIONS 64
+#define EPA_MAX_ITERATIONS 64
+#define GJK_HILL_CLIMB_VERTICES 32
+
+// A convex piece laid out for support queries: positions as padded structure-of-arrays for the SIMD scan,
+// and vertex adjacency (CSR) for hill climbing on larger hulls. Bounds serve the broadphase. The arrays are
+// the only copy of the positions, and rays are clipped against the object's hull blob, so no planes are kept.
+typedef struct collisionHull {
+    int vertexCount;
+    std::vector<float> x, y, z;
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+    glm::vec3 center;
+    glm::vec3 boundsMin, boundsMax;
+} CollisionHull;
+
+typedef struct shapeInstance {
+    const CollisionHull* hull;
+    glm::mat4 transform;
+    glm::mat3 directionTransform;
+} ShapeInstance;
+
+typedef struct supportPoint {
+    glm::vec3 w, a, b;
+    int indexA, indexB;
+} SupportPoint;
+
+typedef struct gjkSimplex {
+    SupportPoint points[4];
+    float weights[4];
+    int count;
+} GJKSimplex;
+
+// Support vertex indices of the final simplex, used to seed the next query on the same pair.
+typedef struct warmStart {
+    int count;
+    int indexA[4], indexB[4];
+} WarmStart;
+
+// normal points from A into B; distance is set when separated, penetration when intersecting.
+typedef struct collisionResult {
+    bool intersecting;
+    float distance;
+    float penetration;
+    glm::vec3 normal;
+    glm::vec3 pointA, pointB;
+} CollisionResult;
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Collision hulls //
+// ------------------------------------------------------------------------------------------------------------- //
+
+CollisionHull CreateCollisionHull(const ConvexHull& hull) {
+    
+    CollisionHull shape;
+    shape.vertexCount = (int)hull.vertices.size();
+    shape.center = ComputeHullCentroid(hull);
+    shape.boundsMin = hull.vertices.empty() ? shape.center : glm::vec3(FLT_MAX);
+    shape.boundsMax = hull.vertices.empty() ? shape.center : glm::vec3(-FLT_MAX);
+    for (const glm::vec3& vertex : hull.vertices) {
+        shape.boundsMin = glm::min(shape.boundsMin, vertex);
+        shape.boundsMax = glm::max(shape.boundsMax, vertex);
+    }
+    
+    size_t padded = (hull.vertices.size() + 3) & ~(size_t)3;
+    for (size_t i = 0; i < padded; i++) {
+        const glm::vec3& vertex = hull.vertices.empty() ? shape.center : hull.vertices[i < hull.vertices.size() ? i : 0];
+        shape.x.push_back(vertex.x);
+        shape.y.push_back(vertex.y);
+        shape.z.push_back(vertex.z);
+    }
+    
+    std::vector<std::vector<uint32_t>> neighbors(hull.vertices.size());
+    for (const std::array<int, 3>& face : hull.faces) {
+        for (int edge = 0; edge < 3; edge++) {
+            neighbors[face[edge]].push_back(face[(edge + 1) % 3]);
+            neighbors[face[(edge + 1) % 3]].push_back(face[edge]);
+        }
+    }
+    shape.adjacencyOffsets.push_back(0);
+    for (std::vector<uint32_t>& around : neighbors) {
+        std::sort(around.begin(), around.end());
+        around.erase(std::unique(around.begin(), around.end()), around.end());
+        shape.adjacency.insert(shape.adjacency.end(), around.begin(), around.end());
+        shape.adjacencyOffsets.push_back((uint32_t)shape.adjacency.size());
+    }
+    return shape;
+}
+
+inline glm::vec3 GetHullVertex(const CollisionHull& hull, int index) {
+    return glm::vec3(hull.x[index], hull.y[index], hull.z[index]);
+}
+
+ShapeInstance CreateShapeInstance(const CollisionHull& hull, const glm::mat4& transform) {
+    return ShapeInstance{&hull, transform, glm::transpose(glm::mat3(transform))};
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Support //
+// ------------------------------------------------------------------------------------------------------------- //
+
+int SupportIndexScan(const CollisionHull& hull, const glm::vec3& direction) {
+    
+    static const float laneIndices[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    
+    const float4 directionX = Float4Set(direction.x), directionY = Float4Set(direction.y), directionZ = Float4Set(direction.z);
+    float4 bestDot = Float4Set(-FLT_MAX);
+    float4 bestIndex = Float4Set(0.0f);
+    float4 index = Float4Load(laneIndices);
+    const float4 step = Float4Set(4.0f);
+    
+    for (size_t i = 0; i < hull.x.size(); i += 4) {
+        float4 dot = Float4Add(Float4Add(Float4Mul(Float4Load(&hull.x[i]), directionX), Float4Mul(Float4Load(&hull.y[i]), directionY)), Float4Mul(Float4Load(&hull.z[i]), directionZ));
+        float4 mask = Float4Greater(dot, bestDot);
+        bestDot = Float4Select(mask, dot, bestDot);
+        bestIndex = Float4Select(mask, index, bestIndex);
+        index = Float4Add(index, step);
+    }
+    
+    float dots[4], indices[4];
+    Float4Store(dots, bestDot);
+    Float4Store(indices, bestIndex);
+    int lane = 0;
+    for (int i = 1; i < 4; i++) {
+        if (dots[i] > dots[lane]) lane = i;
+    }
+    return (int)indices[lane];
+}
+
+// Walks the hull's edges uphill from hint; on a convex polytope the first local maximum is the support vertex.
+int SupportIndex(const CollisionHull& hull, const glm::vec3& direction, int hint) {
+    
+    if (hull.vertexCount <= GJK_HILL_CLIMB_VERTICES || hint < 0 || hint >= hull.vertexCount) {
+        return SupportIndexScan(hull, direction);
+    }
+    
+    int current = hint;
+    float best = glm::dot(GetHullVertex(hull, current), direction);
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (uint32_t i = hull.adjacencyOffsets[current]; i < hull.adjacencyOffsets[current + 1]; i++) {
+            float value = glm::dot(GetHullVertex(hull, hull.adjacency[i]), direction);
+            if (value > best) {
+                best = value;
+                current = (int)hull.adjacency[i];
+                improved = true;
+            }
+        }
+    }
+    return current;
+}
+
+SupportPoint MinkowskiPoint(const ShapeInstance& A, const ShapeInstance& B, int indexA, int indexB) {
+    
+    SupportPoint point;
+    point.indexA = indexA;
+    point.indexB = indexB;
+    point.a = glm::vec3(A.transform * glm::vec4(GetHullVertex(*A.hull, indexA), 1.0f));
+    point.b = glm::vec3(B.transform * glm::vec4(GetHullVertex(*B.hull, indexB), 1.0f));
+    point.w = point.a - point.b;
+    return point;
+}
+
+// Support of A - B in world space. Directions go to each hull's local space through the transpose of its
+// linear part, which keeps this correct under non-uniform scale.
+SupportPoint MinkowskiSupport(const ShapeInstance& A, const ShapeInstance& B, const glm::vec3& direction, int hintA, int hintB) {
+    
+    int indexA = SupportIndex(*A.hull, A.directionTransform * direction, hintA);
+    int indexB = SupportIndex(*B.hull, B.directionTransform * -direction, hintB);
+    return MinkowskiPoint(A, B, indexA, indexB);
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Simplex solver //
+// ------------------------------------------------------------------------------------------------------------- //
+
+void SetSimplex(GJKSimplex& simplex, std::initializer_list<std::pair<SupportPoint, float>> points) {
+    simplex.count = 0;
+    for (const std::pair<SupportPoint, float>& point : points) {
+        simplex.points[simplex.count] = point.first;
+        simplex.weights[simplex.count] = point.second;
+        simplex.count++;
+    }
+}
+
+// Closest point of triangle ABC to the origin (Ericson, Real-Time Collision Detection 5.1.5), reducing the
+// simplex to the feature it lies on.
+void SolveTriangle(GJKSimplex& simplex, const SupportPoint& A, const SupportPoint& B, const SupportPoint& C) {
+    
+    glm::vec3 ab = B.w - A.w, ac = C.w - A.w;
+    
+    float d1 = glm::dot(ab, -A.w), d2 = glm::dot(ac, -A.w);
+    if (d1 <= 0.0f && d2 <= 0.0f) return SetSimplex(simplex, {{A, 1.0f}});
+    
+    float d3 = glm::dot(ab, -B.w), d4 = glm::dot(ac, -B.w);
+    if (d3 >= 0.0f && d4 <= d3) return SetSimplex(simplex, {{B, 1.0f}});
+    
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        return SetSimplex(simplex, {{A, 1.0f - v}, {B, v}});
+    }
+    
+    float d5 = glm::dot(ab, -C.w), d6 = glm::dot(ac, -C.w);
+    if (d6 >= 0.0f && d5 <= d6) return SetSimplex(simplex, {{C, 1.0f}});
+    
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        return SetSimplex(simplex, {{A, 1.0f - w}, {C, w}});
+    }
+    
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return SetSimplex(simplex, {{B, 1.0f - w}, {C, w}});
+    }
+    
+    float denominator = va + vb + vc;
+    if (denominator <= 0.0f) return SetSimplex(simplex, {{A, 1.0f}});
+    float v = vb / denominator, w = vc / denominator;
+    SetSimplex(simplex, {{A, 1.0f - v - w}, {B, v}, {C, w}});
+}
+
+glm::vec3 SimplexPoint(const GJKSimplex& simplex) {
+    glm::vec3 point = glm::vec3(0.0f);
+    for (int i = 0; i < simplex.count; i++) {
+        point += simplex.points[i].w * simplex.weights[i];
+    }
+    return point;
+}
+
+// Replaces the simplex with the smallest sub-simplex supporting its closest point to the origin. Returns
+// false when the origin is enclosed by a tetrahedron.
+bool SolveSimplex(GJKSimplex& simplex) {
+    
+    SupportPoint A = simplex.points[0], B = simplex.points[1], C = simplex.points[2], D = simplex.points[3];
+    
+    switch (simplex.count) {
+        case 1:
+            simplex.weights[0] = 1.0f;
+            return true;
+        
+        case 2: {
+            glm::vec3 ab = B.w - A.w;
+            float lengthSquared = glm::dot(ab, ab);
+            float t = lengthSquared > 0.0f ? glm::dot(-A.w, ab) / lengthSquared : 0.0f;
+            if (t <= 0.0f)      SetSimplex(simplex, {{A, 1.0f}});
+            else if (t >= 1.0f) SetSimplex(simplex, {{B, 1.0f}});
+            else                SetSimplex(simplex, {{A, 1.0f - t}, {B, t}});
+            return true;
+        }
+        
+        case 3:
+            SolveTriangle(simplex, A, B, C);
+            return true;
+        
+        default: {
+            // Only the faces the origin lies in front of can hold the closest point
+            const SupportPoint* faces[4][4] = {{&A, &B, &C, &D}, {&A, &C, &D, &B}, {&A, &D, &B, &C}, {&B, &D, &C, &A}};
+            bool enclosed = true;
+            float bestDistance = FLT_MAX;
+            GJKSimplex best = simplex;
+            
+            for (const auto& face : faces) {
+                glm::vec3 normal = glm::cross(face[1]->w - face[0]->w, face[2]->w - face[0]->w);
+                float originSide = glm::dot(normal, -face[0]->w);
+                float oppositeSide = glm::dot(normal, face[3]->w - face[0]->w);
+                if (originSide * oppositeSide >= 0.0f && oppositeSide != 0.0f) continue;
+                
+                enclosed = false;
+                GJKSimplex candidate;
+                SolveTriangle(candidate, *face[0], *face[1], *face[2]);
+                glm::vec3 point = SimplexPoint(candidate);
+                float distance = glm::dot(point, point);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = candidate;
+                }
+            }
+            if (enclosed) return false;
+            simplex = best;
+            return true;
+        }
+    }
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// EPA //
+// ------------------------------------------------------------------------------------------------------------- //
+
+typedef struct epaFace {
+    int vertices[3];
+    glm::vec3 normal;
+    float distance;
+} EPAFace;
+
+// Expands the GJK simplex into the face of A - B nearest the origin, giving penetration depth and normal.
+void ExpandPolytope(const ShapeInstance& A, const ShapeInstance& B, const GJKSimplex& simplex, CollisionResult& result) {
+    
+    std::vector<SupportPoint> points(simplex.points, simplex.points + simplex.count);
+    
+    // Blow a lower-dimensional simplex up into a tetrahedron
+    const glm::vec3 axes[6] = {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)};
+    for (int axis = 0; axis < 6 && points.size() < 4; axis++) {
+        glm::vec3 direction = axes[axis];
+        if (points.size() == 3) {
+            direction = glm::cross(points[1].w - points[0].w, points[2].w - points[0].w);
+            if (axis % 2) direction = -direction;
+        }
+        else if (points.size() == 2) {
+            glm::vec3 line = points[1].w - points[0].w;
+            direction = glm::cross(line, axes[axis]);
+        }
+        if (glm::dot(direction, direction) < 1e-12f) continue;
+        
+        SupportPoint candidate = MinkowskiSupport(A, B, direction, points[0].indexA, points[0].indexB);
+        bool duplicate = false;
+        for (const SupportPoint& point : points) {
+            duplicate = duplicate || glm::length(candidate.w - point.w) < 1e-6f;
+        }
+        if (points.size() == 3 && glm::abs(glm::dot(direction, candidate.w - points[0].w)) < 1e-6f) duplicate = true;
+        if (!duplicate) points.push_back(candidate);
+    }
+    
+    result.penetration = 0.0f;
+    result.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    result.pointA = points[0].a;
+    result.pointB = points[0].b;
+    if (points.size() < 4) return;
+    
+    glm::vec3 interior = (points[0].w + points[1].w + points[2].w + points[3].w) * 0.25f;
+    std::vector<EPAFace> faces;
+    
+    auto addFace = [&](int a, int b, int c) {
+        glm::vec3 normal = glm::cross(points[b].w - points[a].w, points[c].w - points[a].w);
+        float length = glm::length(normal);
+        if (length < 1e-12f) return;
+        normal /= length;
+        if (glm::dot(normal, points[a].w - interior) < 0.0f) {
+            std::swap(b, c);
+            normal = -normal;
+        }
+        faces.push_back({{a, b, c}, normal, glm::dot(normal, points[a].w)});
+    };
+    addFace(0, 1, 2);
+    addFace(0, 3, 1);
+    addFace(0, 2, 3);
+    addFace(1, 3, 2);
+    
+    std::vector<std::pair<int, int>> horizon;
+    int closest = 0;
+    for (int iteration = 0; iteration < EPA_MAX_ITERATIONS && !faces.empty(); iteration++) {
+        
+        closest = 0;
+        for (int i = 1; i < (int)faces.size(); i++) {
+            if (faces[i].distance < faces[closest].distance) closest = i;
+        }
+        
+        const EPAFace nearest = faces[closest];
+        SupportPoint support = MinkowskiSupport(A, B, nearest.normal, points[nearest.vertices[0]].indexA, points[nearest.vertices[0]].indexB);
+        if (glm::dot(support.w, nearest.normal) - nearest.distance < 1e-4f * std::max(nearest.distance, 1e-3f)) break;
+        
+        int added = (int)points.size();
+        points.push_back(support);
+        
+        horizon.clear();
+        for (int i = (int)faces.size() - 1; i >= 0; i--) {
+            if (glm::dot(faces[i].normal, support.w - points[faces[i].vertices[0]].w) <= 0.0f) continue;
+            
+            for (int edge = 0; edge < 3; edge++) {
+                std::pair<int, int> current = {faces[i].vertices[edge], faces[i].vertices[(edge + 1) % 3]};
+                auto twin = std::find(horizon.begin(), horizon.end(), std::make_pair(current.second, current.first));
+                if (twin != horizon.end()) horizon.erase(twin);
+                else horizon.push_back(current);
+            }
+            faces[i] = faces.back();
+            faces.pop_back();
+        }
+        for (const std::pair<int, int>& edge : horizon) {
+            addFace(edge.first, edge.second, added);
+        }
+        closest = -1;
+    }
+    if (faces.empty()) return;
+    if (closest < 0) {
+        closest = 0;
+        for (int i = 1; i < (int)faces.size(); i++) {
+            if (faces[i].distance < faces[closest].distance) closest = i;
+        }
+    }
+    
+    // Witness points from the barycentric coordinates of the origin's projection onto the nearest face
+    const EPAFace& face = faces[closest];
+    const SupportPoint& P0 = points[face.vertices[0]];
+    const SupportPoint& P1 = points[face.vertices[1]];
+    const SupportPoint& P2 = points[face.vertices[2]];
+    glm::vec3 projected = face.normal * face.distance;
+    
+    glm::vec3 v0 = P1.w - P0.w, v1 = P2.w - P0.w, v2 = projected - P0.w;
+    float d00 = glm::dot(v0, v0), d01 = glm::dot(v0, v1), d11 = glm::dot(v1, v1), d20 = glm::dot(v2, v0), d21 = glm::dot(v2, v1);
+    float denominator = d00 * d11 - d01 * d01;
+    float v = denominator != 0.0f ? (d11 * d20 - d01 * d21) / denominator : 0.0f;
+    float w = denominator != 0.0f ? (d00 * d21 - d01 * d20) / denominator : 0.0f;
+    float u = 1.0f - v - w;
+    
+    result.penetration = face.distance;
+    result.normal = face.normal;
+    result.pointA = P0.a * u + P1.a * v + P2.a * w;
+    result.pointB = P0.b * u + P1.b * v + P2.b * w;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// GJK //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Distance / intersection between two convex pieces. warm holds the previous final simplex for this pair
+// and is overwritten with the new one.
+CollisionResult GJK(const ShapeInstance& A, const ShapeInstance& B, WarmStart& warm, bool computePenetration) {
+    
+    CollisionResult result{false, 0.0f, 0.0f, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f)};
+    if (A.hull->vertexCount == 0 || B.hull->vertexCount == 0) return result;
+    
+    GJKSimplex simplex;
+    simplex.count = 0;
+    for (int i = 0; i < warm.count; i++) {
+        if (warm.indexA[i] < A.hull->vertexCount && warm.indexB[i] < B.hull->vertexCount) {
+            simplex.points[simplex.count++] = MinkowskiPoint(A, B, warm.indexA[i], warm.indexB[i]);
+        }
+    }
+    if (simplex.count == 0) {
+        glm::vec3 centerA = glm::vec3(A.transform * glm::vec4(A.hull->center, 1.0f));
+        glm::vec3 centerB = glm::vec3(B.transform * glm::vec4(B.hull->center, 1.0f));
+        glm::vec3 direction = centerB - centerA;
+        if (glm::dot(direction, direction) < 1e-12f) direction = glm::vec3(1.0f, 0.0f, 0.0f);
+        simplex.points[simplex.count++] = MinkowskiSupport(A, B, -direction, -1, -1);
+    }
+    
+    glm::vec3 closest = simplex.points[0].w;
+    bool enclosed = false;
+    
+    for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++) {
+        
+        if (!SolveSimplex(simplex)) {
+            enclosed = true;
+            break;
+        }
+        closest = SimplexPoint(simplex);
+        float distanceSquared = glm::dot(closest, closest);
+        if (distanceSquared < 1e-12f) {
+            enclosed = true;
+            break;
+        }
+        
+        const SupportPoint& last = simplex.points[simplex.count - 1];
+        SupportPoint support = MinkowskiSupport(A, B, -closest, last.indexA, last.indexB);
+        
+        bool repeated = false;
+        for (int i = 0; i < simplex.count; i++) {
+            repeated = repeated || (simplex.points[i].indexA == support.indexA && simplex.points[i].indexB == support.indexB);
+        }
+        if (repeated || distanceSquared - glm::dot(closest, support.w) <= 1e-6f * distanceSquared) break;
+        
+        simplex.points[simplex.count++] = support;
+    }
+    
+    warm.count = simplex.count;
+    for (int i = 0; i < simplex.count; i++) {
+        warm.indexA[i] = simplex.points[i].indexA;
+        warm.indexB[i] = simplex.points[i].indexB;
+    }
+    
+    if (enclosed) {
+        result.intersecting = true;
+        if (computePenetration) ExpandPolytope(A, B, simplex, result);
+        return result;
+    }
+    
+    result.distance = glm::length(closest);
+    result.normal = -closest / result.distance;
+    result.pointA = glm::vec3(0.0f);
+    result.pointB = glm::vec3(0.0f);
+    for (int i = 0; i < simplex.count; i++) {
+        result.pointA += simplex.points[i].a * simplex.weights[i];
+        result.pointB += simplex.points[i].b * simplex.weights[i];
+    }
+    return result;
+}
+
+#endif /* gjk_h */
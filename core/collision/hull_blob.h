@@ -0,0 +1,332 @@
+//
+//  hull_blob.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef hull_blob_h
+#define hull_blob_h
+
+#include <cstring>
+
+#define HULL_BLOB_MAGIC 0x424C5548u
+#define HULL_BLOB_VERSION 3
+
+// Layout of a blob, in native byte order and without pointers so a file can be mapped and used as is:
+//
+//   HullBlobHeader
+//   HullBlobEntry[hullCount]
+//   per hull, 4-byte aligned: vertices as uint16 x3, faces as uint8 x3 (up to 256 vertices), uint16 x3
+//   (up to 65536) or uint32 x3, then one HullBlobPlane per face followed by the edge planes of a flat hull
+//
+// Vertices are quantised to 16 bits inside the hull's own box, half a step (1/131070 of the box) along
+// each axis plus float rounding. The planes are fitted to the quantised vertices, so they bound the hull
+// the blob actually describes.
+typedef struct hullBlobHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t hullCount;
+    uint32_t size;
+} HullBlobHeader;
+
+typedef struct hullBlobEntry {
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t vertices, faces, planes;
+    uint32_t vertexCount, faceCount, planeCount;
+} HullBlobEntry;
+
+// Bytes per face index: the smallest width that can address every vertex of the hull.
+inline size_t GetHullBlobIndexSize(size_t vertexCount) {
+    return vertexCount <= 256 ? 1 : vertexCount <= 65536 ? 2 : 4;
+}
+
+// Normal in signed 16-bit fixed point; offset is FLT_MAX for faces that collapsed to a line.
+typedef struct hullBlobPlane {
+    int16_t normal[3];
+    int16_t padding;
+    float offset;
+} HullBlobPlane;
+
+class HullBlob {
+public:
+    static HullBlob Create(const std::vector<ConvexHull>& hulls);
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+    
+    size_t Size() const { return file ? file->Size() : storage.size(); }
+    size_t GetHullCount() const { return Size() == 0 ? 0 : GetHeader().hullCount; }
+    const HullBlobEntry& GetEntry(size_t hull) const;
+    
+    glm::vec3 GetVertex(size_t hull, size_t vertex) const;
+    std::array<int, 3> GetFace(size_t hull, size_t face) const;
+    glm::vec4 GetPlane(size_t hull, size_t index) const;
+    ConvexHull Decode(size_t hull) const;
+    
+    glm::vec3 Support(size_t hull, const glm::vec3& direction) const;
+    float Raycast(size_t hull, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, int& enterPlane) const;
+    
+private:
+    std::vector<uint8_t> storage;
+    std::shared_ptr<MappedFile> file;
+    
+    const uint8_t* Data() const { return file ? (const uint8_t*)file->Data() : storage.data(); }
+    const HullBlobHeader& GetHeader() const { return *(const HullBlobHeader*)Data(); }
+    bool Validate() const;
+};
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Create //
+// ------------------------------------------------------------------------------------------------------------- //
+
+HullBlob HullBlob::Create(const std::vector<ConvexHull>& hulls) {
+    
+    auto aligned = [](size_t size) { return (size + 3) & ~(size_t)3; };
+    
+    // Step 1: Lay out every hull's arrays after the header and the entry table
+    std::vector<HullBlobEntry> entries(hulls.size());
+    std::vector<std::vector<glm::vec4>> edgePlanes(hulls.size());
+    size_t size = sizeof(HullBlobHeader) + hulls.size() * sizeof(HullBlobEntry);
+    for (size_t i = 0; i < hulls.size(); i++) {
+        const ConvexHull& hull = hulls[i];
+        edgePlanes[i] = ComputeEdgePlanes(hull);
+        
+        HullBlobEntry& entry = entries[i];
+        entry.vertexCount = (uint32_t)hull.vertices.size();
+        entry.faceCount = (uint32_t)hull.faces.size();
+        entry.planeCount = (uint32_t)(hull.faces.size() + edgePlanes[i].size());
+        entry.vertices = (uint32_t)size;
+        size = aligned(size + (size_t)entry.vertexCount * 3 * sizeof(uint16_t));
+        entry.faces = (uint32_t)size;
+        size = aligned(size + (size_t)entry.faceCount * 3 * GetHullBlobIndexSize(entry.vertexCount));
+        entry.planes = (uint32_t)size;
+        size += (size_t)entry.planeCount * sizeof(HullBlobPlane);
+    }
+    if (size > UINT32_MAX) throw std::runtime_error("Hull blob exceeds 4 GB");
+    
+    HullBlob blob;
+    blob.storage.assign(size, 0);
+    *(HullBlobHeader*)blob.storage.data() = HullBlobHeader{HULL_BLOB_MAGIC, HULL_BLOB_VERSION, (uint32_t)hulls.size(), (uint32_t)size};
+    
+    // Step 2: Quantise, then fit the planes to what was stored
+    uint8_t* data = blob.storage.data();
+    threadPool.ParallelFor(hulls.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const ConvexHull& hull = hulls[i];
+            HullBlobEntry& entry = entries[i];
+            
+            glm::vec3 boundsMin = hull.vertices.empty() ? glm::vec3(0.0f) : hull.vertices[0];
+            glm::vec3 boundsMax = boundsMin;
+            for (const glm::vec3& vertex : hull.vertices) {
+                boundsMin = glm::min(boundsMin, vertex);
+                boundsMax = glm::max(boundsMax, vertex);
+            }
+            for (int axis = 0; axis < 3; axis++) {
+                entry.boundsMin[axis] = boundsMin[axis];
+                entry.boundsMax[axis] = boundsMax[axis];
+            }
+            std::memcpy(data + sizeof(HullBlobHeader) + i * sizeof(HullBlobEntry), &entry, sizeof(HullBlobEntry));
+            
+            glm::vec3 extent = boundsMax - boundsMin;
+            uint16_t* vertices = (uint16_t*)(data + entry.vertices);
+            for (size_t v = 0; v < hull.vertices.size(); v++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    float t = extent[axis] > 0.0f ? (hull.vertices[v][axis] - boundsMin[axis]) / extent[axis] : 0.0f;
+                    vertices[v * 3 + axis] = (uint16_t)std::lround(glm::clamp(t, 0.0f, 1.0f) * 65535.0f);
+                }
+            }
+            
+            for (size_t f = 0; f < hull.faces.size(); f++) {
+                for (int corner = 0; corner < 3; corner++) {
+                    switch (GetHullBlobIndexSize(entry.vertexCount)) {
+                        case 1: data[entry.faces + f * 3 + corner] = (uint8_t)hull.faces[f][corner]; break;
+                        case 2: ((uint16_t*)(data + entry.faces))[f * 3 + corner] = (uint16_t)hull.faces[f][corner]; break;
+                        default: ((uint32_t*)(data + entry.faces))[f * 3 + corner] = (uint32_t)hull.faces[f][corner]; break;
+                    }
+                }
+            }
+            
+            // The offset of the rounded normal is taken over all vertices, so no vertex lies outside
+            auto fitPlane = [&](HullBlobPlane& plane, const glm::vec3& normal) {
+                for (int axis = 0; axis < 3; axis++) {
+                    plane.normal[axis] = (int16_t)std::lround(normal[axis] * 32767.0f);
+                }
+                plane.padding = 0;
+                
+                glm::vec3 stored = glm::vec3(plane.normal[0], plane.normal[1], plane.normal[2]) / 32767.0f;
+                plane.offset = -FLT_MAX;
+                for (size_t v = 0; v < hull.vertices.size(); v++) {
+                    plane.offset = std::max(plane.offset, glm::dot(stored, blob.GetVertex(i, v)));
+                }
+            };
+            
+            HullBlobPlane* planes = (HullBlobPlane*)(data + entry.planes);
+            for (size_t f = 0; f < hull.faces.size(); f++) {
+                glm::vec3 A = blob.GetVertex(i, hull.faces[f][0]);
+                glm::vec3 B = blob.GetVertex(i, hull.faces[f][1]);
+                glm::vec3 C = blob.GetVertex(i, hull.faces[f][2]);
+                glm::vec3 normal = glm::cross(B - A, C - A);
+                float length = glm::length(normal);
+                
+                if (length <= 0.0f) planes[f] = HullBlobPlane{{0, 0, 0}, 0, FLT_MAX};
+                else fitPlane(planes[f], normal / length);
+            }
+            for (size_t e = 0; e < edgePlanes[i].size(); e++) {
+                fitPlane(planes[hull.faces.size() + e], glm::vec3(edgePlanes[i][e]));
+            }
+        }
+    });
+    return blob;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Load / Save //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Maps the file and uses it in place; nothing is copied.
+bool HullBlob::Load(const std::string& path) {
+    
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>();
+    if (!mapped->Open(path)) return false;
+    
+    HullBlob candidate;
+    candidate.file = mapped;
+    if (!candidate.Validate()) return false;
+    
+    storage.clear();
+    file = mapped;
+    return true;
+}
+
+bool HullBlob::Save(const std::string& path) const {
+    
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output) return false;
+    output.write((const char*)Data(), (std::streamsize)Size());
+    return (bool)output;
+}
+
+// Every offset a query could follow has to stay inside the blob.
+bool HullBlob::Validate() const {
+    
+    if (Size() < sizeof(HullBlobHeader)) return false;
+    const HullBlobHeader& header = GetHeader();
+    if (header.magic != HULL_BLOB_MAGIC || header.version != HULL_BLOB_VERSION || header.size != Size()) return false;
+    if (sizeof(HullBlobHeader) + (size_t)header.hullCount * sizeof(HullBlobEntry) > Size()) return false;
+    
+    for (size_t i = 0; i < header.hullCount; i++) {
+        const HullBlobEntry& entry = GetEntry(i);
+        size_t indexSize = GetHullBlobIndexSize(entry.vertexCount);
+        if ((entry.vertices | entry.faces | entry.planes) & 3) return false;
+        if ((size_t)entry.vertices + (size_t)entry.vertexCount * 3 * sizeof(uint16_t) > Size()) return false;
+        if ((size_t)entry.faces + (size_t)entry.faceCount * 3 * indexSize > Size()) return false;
+        if (entry.planeCount < entry.faceCount) return false;
+        if ((size_t)entry.planes + (size_t)entry.planeCount * sizeof(HullBlobPlane) > Size()) return false;
+        
+        for (size_t f = 0; f < entry.faceCount; f++) {
+            std::array<int, 3> face = GetFace(i, f);
+            for (int corner : face) {
+                if (corner < 0 || (uint32_t)corner >= entry.vertexCount) return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Queries //
+// ------------------------------------------------------------------------------------------------------------- //
+
+const HullBlobEntry& HullBlob::GetEntry(size_t hull) const {
+    return ((const HullBlobEntry*)(Data() + sizeof(HullBlobHeader)))[hull];
+}
+
+glm::vec3 HullBlob::GetVertex(size_t hull, size_t vertex) const {
+    
+    const HullBlobEntry& entry = GetEntry(hull);
+    const uint16_t* quantised = (const uint16_t*)(Data() + entry.vertices) + vertex * 3;
+    glm::vec3 boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+    glm::vec3 boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+    return boundsMin + (boundsMax - boundsMin) * (glm::vec3(quantised[0], quantised[1], quantised[2]) / 65535.0f);
+}
+
+std::array<int, 3> HullBlob::GetFace(size_t hull, size_t face) const {
+    
+    const HullBlobEntry& entry = GetEntry(hull);
+    switch (GetHullBlobIndexSize(entry.vertexCount)) {
+        case 1: {
+            const uint8_t* indices = Data() + entry.faces + face * 3;
+            return {indices[0], indices[1], indices[2]};
+        }
+        case 2: {
+            const uint16_t* indices = (const uint16_t*)(Data() + entry.faces) + face * 3;
+            return {indices[0], indices[1], indices[2]};
+        }
+        default: {
+            const uint32_t* indices = (const uint32_t*)(Data() + entry.faces) + face * 3;
+            return {(int)indices[0], (int)indices[1], (int)indices[2]};
+        }
+    }
+}
+
+// Plane as (normal, offset) with dot(normal, p) <= offset inside. The normal is within 1/32767 of unit length.
+// Planes below faceCount belong to the faces of the same index, the rest to the edges of a flat hull.
+glm::vec4 HullBlob::GetPlane(size_t hull, size_t index) const {
+    
+    const HullBlobPlane& plane = ((const HullBlobPlane*)(Data() + GetEntry(hull).planes))[index];
+    return glm::vec4(glm::vec3(plane.normal[0], plane.normal[1], plane.normal[2]) / 32767.0f, plane.offset);
+}
+
+ConvexHull HullBlob::Decode(size_t hull) const {
+    
+    const HullBlobEntry& entry = GetEntry(hull);
+    ConvexHull decoded;
+    for (size_t v = 0; v < entry.vertexCount; v++) {
+        decoded.vertices.push_back(GetVertex(hull, v));
+    }
+    for (size_t f = 0; f < entry.faceCount; f++) {
+        decoded.faces.push_back(GetFace(hull, f));
+    }
+    return decoded;
+}
+
+// Furthest vertex along direction. Compares in quantised units, which are the box's axes scaled, so the
+// vertices are only decoded once the winner is known. An empty hull has no vertex to return, so it answers
+// with the centre of its (degenerate) box.
+glm::vec3 HullBlob::Support(size_t hull, const glm::vec3& direction) const {
+    
+    const HullBlobEntry& entry = GetEntry(hull);
+    if (entry.vertexCount == 0) {
+        return (glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]) +
+                glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2])) * 0.5f;
+    }
+    
+    const uint16_t* quantised = (const uint16_t*)(Data() + entry.vertices);
+    glm::vec3 scaled = direction * (glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]) -
+                                    glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]));
+    
+    size_t best = 0;
+    float bestDistance = -FLT_MAX;
+    for (size_t v = 0; v < entry.vertexCount; v++) {
+        float distance = scaled.x * quantised[v * 3] + scaled.y * quantised[v * 3 + 1] + scaled.z * quantised[v * 3 + 2];
+        if (distance > bestDistance) {
+            bestDistance = distance;
+            best = v;
+        }
+    }
+    return GetVertex(hull, best);
+}
+
+// Same contract as RayClipPlanes, against the stored planes.
+float HullBlob::Raycast(size_t hull, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, int& enterPlane) const {
+    return RayClipPlanes(GetEntry(hull).planeCount, [&](size_t i) { return GetPlane(hull, i); }, origin, direction, maxDistance, enterPlane);
+}
+
+#endif /* hull_blob_h */
@@ -0,0 +1,320 @@
+//
+//  hull_tree.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef hull_tree_h
+#define hull_tree_h
+
+#include <queue>
+
+#define HULL_TREE_NULL -1
+#define HULL_TREE_LINK_WINDOW 8
+
+typedef struct hullTreeNode {
+    AABB box;
+    ConvexHull hull;
+    int parent;
+    int child1, child2;
+    int height;
+    int piece;
+    float pieceVolume;
+    float error;
+} HullTreeNode;
+
+typedef struct hullTreeHit {
+    int piece;
+    Intersection intersection;
+} HullTreeHit;
+
+// Clips a ray against the planes getPlane(0 .. count - 1), each (normal, offset) with the inside where
+// dot(normal, p) <= offset; planes with an offset of FLT_MAX are skipped. Returns the entry distance, 0 when
+// the origin is already inside, or -1 for a miss; enterPlane is the plane the ray entered through, -1 if
+// it started inside. A hull with no planes at all is a point or a segment, which no ray hits.
+template<typename GetPlane>
+float RayClipPlanes(size_t count, GetPlane getPlane, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, int& enterPlane) {
+    
+    float enter = 0.0f, exit = maxDistance;
+    enterPlane = -1;
+    bool bounded = false;
+    for (size_t i = 0; i < count; i++) {
+        glm::vec4 plane = getPlane(i);
+        if (plane.w == FLT_MAX) continue;
+        bounded = true;
+        
+        glm::vec3 planeNormal = glm::vec3(plane);
+        float facing = glm::dot(planeNormal, direction);
+        float gap = plane.w - glm::dot(planeNormal, origin);
+        
+        if (glm::abs(facing) < 1e-12f) {
+            if (gap < 0.0f) return -1.0f;
+            continue;
+        }
+        float t = gap / facing;
+        if (facing < 0.0f) {
+            if (t > enter) {
+                enter = t;
+                enterPlane = (int)i;
+            }
+        }
+        else {
+            exit = std::min(exit, t);
+        }
+        if (enter > exit) return -1.0f;
+    }
+    return bounded ? enter : -1.0f;
+}
+
+// Slab test that also returns where the ray enters the box, or -1 for a miss.
+inline float RayEnterAABB(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+    
+    float enter = 0.0f, exit = maxDistance;
+    for (int axis = 0; axis < 3; axis++) {
+        float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+        float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t1 != t1 || t2 != t2) continue;
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+    }
+    return enter <= exit ? enter : -1.0f;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// HullTree //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Static hierarchy over the convex pieces of one object, in its local space. Leaves are the pieces;
+// every internal node is a merge of two subtrees with the box of everything below it and a convex
+// hull of it, capped at the hull budget. Pieces that touch are merged first, smallest combined box
+// first, so the upper levels follow the parts of the model and make useful coarse hulls.
+//
+// Queries descend from the root and skip whole subtrees on their boxes. SelectLevel cuts the tree
+// where the merged hulls are within an error, for coarse collision or drawing of distant objects.
+class HullTree {
+public:
+    void Build(const std::vector<ConvexHull>& pieces, const std::vector<std::pair<uint32_t, uint32_t>>& adjacentPieces, int maxVertices, int maxFaces);
+    void Clear();
+    
+    template<typename Callback>
+    void Query(const AABB& box, Callback callback) const;
+    template<typename Callback>
+    void Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback callback) const;
+    void SelectLevel(float maxError, std::vector<int>& cut) const;
+    
+    int GetRoot() const { return root; }
+    int GetHeight() const { return root == HULL_TREE_NULL ? 0 : nodes[root].height; }
+    size_t Size() const { return nodes.size(); }
+    const HullTreeNode& GetNode(int node) const { return nodes[node]; }
+    bool IsLeaf(int node) const { return nodes[node].child1 == HULL_TREE_NULL; }
+    
+private:
+    std::vector<HullTreeNode> nodes;
+    int root = HULL_TREE_NULL;
+};
+
+void HullTree::Clear() {
+    nodes.clear();
+    root = HULL_TREE_NULL;
+}
+
+void HullTree::Build(const std::vector<ConvexHull>& pieces, const std::vector<std::pair<uint32_t, uint32_t>>& adjacentPieces,
+                     int maxVertices = ACD_MAX_HULL_VERTICES, int maxFaces = ACD_MAX_HULL_FACES) {
+    
+    Clear();
+    if (pieces.empty()) return;
+    
+    size_t pieceCount = pieces.size();
+    nodes.reserve(pieceCount * 2 - 1);
+    for (size_t i = 0; i < pieceCount; i++) {
+        HullTreeNode leaf{};
+        leaf.box = AABB{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+        for (const glm::vec3& vertex : pieces[i].vertices) {
+            leaf.box.min = glm::min(leaf.box.min, vertex);
+            leaf.box.max = glm::max(leaf.box.max, vertex);
+        }
+        if (pieces[i].vertices.empty()) leaf.box = AABB{glm::vec3(0.0f), glm::vec3(0.0f)};
+        leaf.parent = leaf.child1 = leaf.child2 = HULL_TREE_NULL;
+        leaf.piece = (int)i;
+        nodes.push_back(std::move(leaf));
+    }
+    
+    threadPool.ParallelFor(pieceCount, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            nodes[i].pieceVolume = ComputeHullVolume(pieces[i]);
+        }
+    });
+    
+    // Step 1: Merge the pair of roots with the smallest combined box, adjacent pieces before the rest
+    typedef std::pair<float, std::pair<int, int>> Candidate;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    std::vector<std::set<int>> neighbors(pieceCount * 2 - 1);
+    
+    auto link = [&](int a, int b) {
+        if (a == b || !neighbors[a].insert(b).second) return;
+        neighbors[b].insert(a);
+        candidates.push({AABBSurfaceArea(CombineAABB(nodes[a].box, nodes[b].box)), {a, b}});
+    };
+    for (const std::pair<uint32_t, uint32_t>& adjacent : adjacentPieces) {
+        if (adjacent.first < pieceCount && adjacent.second < pieceCount) link((int)adjacent.first, (int)adjacent.second);
+    }
+    
+    size_t rootCount = pieceCount;
+    while (rootCount > 1) {
+        
+        // Disconnected parts are linked to their nearest roots along the widest axis
+        if (candidates.empty()) {
+            std::vector<int> roots;
+            AABB bounds = nodes[0].box;
+            for (size_t i = 0; i < nodes.size(); i++) {
+                if (nodes[i].parent != HULL_TREE_NULL) continue;
+                roots.push_back((int)i);
+                bounds = CombineAABB(bounds, nodes[i].box);
+            }
+            glm::vec3 size = bounds.max - bounds.min;
+            int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+            std::sort(roots.begin(), roots.end(), [&](int a, int b) {
+                return nodes[a].box.min[axis] + nodes[a].box.max[axis] < nodes[b].box.min[axis] + nodes[b].box.max[axis];
+            });
+            for (size_t i = 0; i < roots.size(); i++) {
+                for (size_t j = i + 1; j < std::min(roots.size(), i + 1 + HULL_TREE_LINK_WINDOW); j++) {
+                    link(roots[i], roots[j]);
+                }
+            }
+        }
+        
+        std::pair<int, int> pair = candidates.top().second;
+        candidates.pop();
+        int a = pair.first, b = pair.second;
+        if (nodes[a].parent != HULL_TREE_NULL || nodes[b].parent != HULL_TREE_NULL) continue;
+        
+        int merged = (int)nodes.size();
+        HullTreeNode node{};
+        node.box = CombineAABB(nodes[a].box, nodes[b].box);
+        node.parent = HULL_TREE_NULL;
+        node.child1 = a;
+        node.child2 = b;
+        node.height = 1 + std::max(nodes[a].height, nodes[b].height);
+        node.piece = HULL_TREE_NULL;
+        node.pieceVolume = nodes[a].pieceVolume + nodes[b].pieceVolume;
+        nodes.push_back(std::move(node));
+        nodes[a].parent = merged;
+        nodes[b].parent = merged;
+        
+        for (int child : {a, b}) {
+            for (int neighbor : neighbors[child]) {
+                neighbors[neighbor].erase(child);
+                if (neighbor != a && neighbor != b) link(merged, neighbor);
+            }
+            std::set<int>().swap(neighbors[child]);
+        }
+        rootCount--;
+    }
+    root = (int)nodes.size() - 1;
+    
+    // Step 2: Hulls of the internal nodes from their children's hulls, one height at a time
+    std::vector<std::vector<int>> levels(nodes[root].height + 1);
+    for (size_t i = pieceCount; i < nodes.size(); i++) {
+        levels[nodes[i].height].push_back((int)i);
+    }
+    
+    for (const std::vector<int>& level : levels) {
+        threadPool.ParallelFor(level.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                HullTreeNode& node = nodes[level[i]];
+                
+                std::vector<glm::vec3> points;
+                for (int child : {node.child1, node.child2}) {
+                    const ConvexHull& hull = IsLeaf(child) ? pieces[nodes[child].piece] : nodes[child].hull;
+                    points.insert(points.end(), hull.vertices.begin(), hull.vertices.end());
+                }
+                node.hull = BuildConvexHull(points);
+                if (maxVertices > 0) node.hull = SimplifyHull(node.hull, maxVertices, maxFaces, 0.0f);
+                
+                // Volume the merged hull adds over its pieces, as a length
+                node.error = std::cbrt(std::max(ComputeHullVolume(node.hull) - node.pieceVolume, 0.0f));
+            }
+        });
+    }
+}
+
+// Cut of the tree where every node's merged hull adds at most maxError (a length, in local units) over
+// the pieces below it. Leaves are taken as they are; for them the piece hull is the node's hull.
+void HullTree::SelectLevel(float maxError, std::vector<int>& cut) const {
+    
+    cut.clear();
+    if (root == HULL_TREE_NULL) return;
+    
+    std::vector<int> stack{root};
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        
+        if (IsLeaf(node) || nodes[node].error <= maxError) {
+            cut.push_back(node);
+            continue;
+        }
+        stack.push_back(nodes[node].child2);
+        stack.push_back(nodes[node].child1);
+    }
+}
+
+// callback(piece) is called for every piece whose box overlaps box; returning false stops the query.
+template<typename Callback>
+void HullTree::Query(const AABB& box, Callback callback) const {
+    
+    if (root == HULL_TREE_NULL) return;
+    
+    std::vector<int> stack{root};
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        if (!AABBOverlaps(nodes[node].box, box)) continue;
+        
+        if (IsLeaf(node)) {
+            if (!callback(nodes[node].piece)) return;
+        }
+        else {
+            stack.push_back(nodes[node].child1);
+            stack.push_back(nodes[node].child2);
+        }
+    }
+}
+
+// callback(piece, maxDistance) returns the hit distance along the ray, or a negative value for a miss.
+// The nearer child is visited first, so the ray usually shrinks before the farther subtree is reached.
+template<typename Callback>
+void HullTree::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback callback) const {
+    
+    if (root == HULL_TREE_NULL) return;
+    
+    glm::vec3 inverseDirection = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float rootEnter = RayEnterAABB(nodes[root].box, origin, inverseDirection, maxDistance);
+    if (rootEnter < 0.0f) return;
+    
+    std::vector<std::pair<float, int>> stack{{rootEnter, root}};
+    while (!stack.empty()) {
+        std::pair<float, int> entry = stack.back();
+        stack.pop_back();
+        if (entry.first > maxDistance) continue;
+        
+        int node = entry.second;
+        if (IsLeaf(node)) {
+            float distance = callback(nodes[node].piece, maxDistance);
+            if (distance >= 0.0f && distance < maxDistance) maxDistance = distance;
+            continue;
+        }
+        
+        float enter1 = RayEnterAABB(nodes[nodes[node].child1].box, origin, inverseDirection, maxDistance);
+        float enter2 = RayEnterAABB(nodes[nodes[node].child2].box, origin, inverseDirection, maxDistance);
+        std::pair<float, int> first{enter1, nodes[node].child1}, second{enter2, nodes[node].child2};
+        if (enter2 >= 0.0f && (enter1 < 0.0f || enter2 < enter1)) std::swap(first, second);
+        if (second.first >= 0.0f) stack.push_back(second);
+        if (first.first >= 0.0f) stack.push_back(first);
+    }
+}
+
+#endif /* hull_tree_h */
@@ -0,0 +1,116 @@
+//
+//  narrow_phase.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-21.
+//
+
+#ifndef narrow_phase_h
+#define narrow_phase_h
+
+// Batches a cached simplex survives without its pair being queried
+#define NARROW_PHASE_CACHE_BATCHES 4
+
+typedef struct collisionQuery {
+    RObject* objectA;
+    int pieceA;
+    RObject* objectB;
+    int pieceB;
+} CollisionQuery;
+
+typedef struct cachedWarmStart {
+    WarmStart warmStart;
+    uint64_t batch;
+} CachedWarmStart;
+
+// Runs GJK / EPA between convex pieces of decomposed objects. The final simplex of every pair is kept
+// and used to seed the next query on that pair, so coherent frames converge in one or two iterations.
+// Each batch counts as a frame: pairs that go NARROW_PHASE_CACHE_BATCHES batches without a query are
+// dropped, which keeps the cache to the pairs in play and lets go of objects that no longer exist.
+class NarrowPhase {
+public:
+    bool computePenetration = true;
+    
+    CollisionResult Query(const CollisionQuery& query);
+    std::vector<CollisionResult> Query(const std::vector<CollisionQuery>& queries);
+    void ClearCache();
+    
+private:
+    std::unordered_map<uint64_t, CachedWarmStart> warmStarts;
+    uint64_t batch = 0;
+    
+    static uint64_t PairKey(const CollisionQuery& query);
+};
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// PairKey //
+// ------------------------------------------------------------------------------------------------------------- //
+
+uint64_t NarrowPhase::PairKey(const CollisionQuery& query) {
+    
+    uint64_t key = 1469598103934665603ull;
+    for (uint64_t value : {(uint64_t)(uintptr_t)query.objectA, (uint64_t)query.pieceA, (uint64_t)(uintptr_t)query.objectB, (uint64_t)query.pieceB}) {
+        key = (key ^ value) * 1099511628211ull;
+        key ^= key >> 29;
+    }
+    return key;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Query //
+// ------------------------------------------------------------------------------------------------------------- //
+
+CollisionResult NarrowPhase::Query(const CollisionQuery& query) {
+    return Query(std::vector<CollisionQuery>{query})[0];
+}
+
+// Batched queries: transforms are built once per object, the cache is read before and written after the
+// parallel section so the workers never touch the map.
+std::vector<CollisionResult> NarrowPhase::Query(const std::vector<CollisionQuery>& queries) {
+    
+    std::unordered_map<RObject*, glm::mat4> transforms;
+    for (const CollisionQuery& query : queries) {
+        if (!transforms.count(query.objectA)) transforms[query.objectA] = query.objectA->CreateModelMatrix();
+        if (!transforms.count(query.objectB)) transforms[query.objectB] = query.objectB->CreateModelMatrix();
+    }
+    
+    std::vector<uint64_t> keys(queries.size());
+    std::vector<WarmStart> seeds(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        keys[i] = PairKey(queries[i]);
+        auto cached = warmStarts.find(keys[i]);
+        seeds[i] = cached != warmStarts.end() ? cached->second.warmStart : WarmStart{0, {}, {}};
+    }
+    
+    std::vector<CollisionResult> results(queries.size());
+    threadPool.ParallelFor(queries.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const CollisionQuery& query = queries[i];
+            ShapeInstance A = CreateShapeInstance(query.objectA->GetCollisionHulls()[query.pieceA], transforms.at(query.objectA));
+            ShapeInstance B = CreateShapeInstance(query.objectB->GetCollisionHulls()[query.pieceB], transforms.at(query.objectB));
+            results[i] = GJK(A, B, seeds[i], computePenetration);
+        }
+    });
+    
+    batch++;
+    for (size_t i = 0; i < queries.size(); i++) {
+        warmStarts[keys[i]] = CachedWarmStart{seeds[i], batch};
+    }
+    
+    // A stale seed is only a poor starting simplex, since GJK checks its indices, so this needn't be exact
+    for (auto entry = warmStarts.begin(); entry != warmStarts.end();) {
+        if (batch - entry->second.batch >= NARROW_PHASE_CACHE_BATCHES) entry = warmStarts.erase(entry);
+        else ++entry;
+    }
+    return results;
+}
+
+void NarrowPhase::ClearCache() {
+    warmStarts.clear();
+}
+
+#endif /* narrow_phase_h */
@@ -29,10 +29,27 @@ GLFWwindow* window;
 #include <glm/vec4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "helper/memory.h"
 #include "helper/thread_pool.h"
+#include "helper/upload_queue.h"
+#include "helper/mapped_file.h"
+#include "helper/simd.h"
+#include "helper/predicates.h"
+#include "helper/frustum.h"
+#include "helper/vertex_layout.h"
 #include "object/camera.h"
 #include "helper/raycast.h"
 #include "acd/acd_util.h"
+#include "acd/weld.h"
+#include "acd/convex_hull.h"
+#include "acd/concavity.h"
+#include "acd/congruence.h"
+#include "acd/simplify.h"
+#include "acd/hull_simplify.h"
+#include "collision/gjk.h"
+#include "collision/aabb_tree.h"
+#include "collision/hull_tree.h"
+#include "collision/hull_blob.h"
 #include "object/shader.h"
 #include "object/object.h"
 
@@ -40,7 +57,14 @@ GLFWwindow* window;
 #include "object/terrain.h"
 
 #include "acd/acd.h"
+#include "object/asset_registry.h"
+#include "helper/mesh_loader.h"
+#include "helper/decomposition_cache.h"
 #include "object/model.h"
+#include "collision/narrow_phase.h"
+#include "collision/broadphase.h"
+#include "helper/benchmark.h"
+#include "helper/farm.h"
 
 void initialize() {
     if (!glfwInit()) {
@@ -66,7 +90,8 @@ void initialize() {
     glEnable(GL_PROGRAM_POINT_SIZE);
     
     Shader shader = Shader::Create("/Users/dmitriwamback/Documents/Projects/GJK/GJK/shader/main");
-    RObject* model = Model::Create("test");
+    AssetFuture asset = Model::LoadAsync("/Users/dmitriwamback/Documents/models/blendermonkey.obj");
+    RObject* model = nullptr;
     //RObject* terrain = Terrain::Create();
     
     camera.Initialize();
@@ -84,7 +109,9 @@ void initialize() {
         float down = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS ? -0.05f : 0;
         
         camera.Update(movement, up, down);
-        std::cout << camera.position.x << " " << camera.position.y << " " << camera.position.z << "\n";
+        std::cout << camera.position.x << " " << camera.position.y << " " << camera.position.z << " | "
+                  << cullingStats.visible << " visible, " << cullingStats.culled << " culled\n";
+        cullingStats = CullingStats{};
         
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.25, 0.25, 0.25, 0.0);
@@ -93,12 +120,29 @@ void initialize() {
         shader.SetMatrix4("projection", camera.projection);
         shader.SetMatrix4("lookAt", camera.lookAt);
         
-        model->Render(shader);
+        uploadQueue.Drain();
+        assetRegistry.Update();
+        
+        // The first frames render without the model until its coarse hulls have been uploaded. A failed
+        // load is reported once and the scene carries on without it.
+        if (!model && asset.valid() && asset.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            try {
+                model = Model::Instantiate(asset.get());
+            }
+            catch (const std::exception& error) {
+                std::cerr << "couldn't load model: " << error.what() << "\n";
+                asset = AssetFuture();
+            }
+        }
+        if (model) model->Render(shader);
         //terrain->Render(shader);
         
         glfwPollEvents();
         glfwSwapBuffers(window);
     }
+    
+    // Stops any background decomposition so the thread pool can shut down
+    delete model;
 }
 
 
@@ -0,0 +1,97 @@
+//
+//  benchmark.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-21.
+//
+
+#ifndef benchmark_h
+#define benchmark_h
+
+#include <chrono>
+#include <random>
+
+double MillisecondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ------------------------------------------------------------------------------------------------------------- //
+// BenchmarkBroadphase //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// objectCount boxes tumbling around a closed room, with the broadphase and narrow phase run every frame.
+// Runs headless; no window or GL context is needed.
+void BenchmarkBroadphase(int objectCount, int frames) {
+    
+    std::vector<glm::vec3> corners;
+    for (int i = 0; i < 8; i++) {
+        corners.push_back(glm::vec3((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+    }
+    ConvexHull box = BuildConvexHull(corners);
+    
+    std::mt19937 random(7);
+    float roomSize = 2.0f * std::cbrt((float)objectCount);
+    std::uniform_real_distribution<float> inside(-roomSize * 0.5f, roomSize * 0.5f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    
+    Broadphase broadphase;
+    NarrowPhase narrowPhase;
+    std::vector<RObject*> objects;
+    std::vector<glm::vec3> velocities, spins;
+    
+    for (int i = 0; i < objectCount; i++) {
+        RObject* object = new RObject();
+        object->position = glm::vec3(inside(random), inside(random), inside(random));
+        object->rotation = glm::vec3(unit(random), unit(random), unit(random)) * 180.0f;
+        object->scale = glm::vec3(1.0f);
+        object->convexHulls = {box};
+        object->BuildCollisionHulls();
+        
+        objects.push_back(object);
+        velocities.push_back(glm::vec3(unit(random), unit(random), unit(random)) * 2.0f);
+        spins.push_back(glm::vec3(unit(random), unit(random), unit(random)) * 90.0f);
+        broadphase.Add(object);
+    }
+    
+    const float deltaTime = 1.0f / 60.0f;
+    double updateTime = 0.0, pairTime = 0.0, narrowTime = 0.0;
+    size_t totalPairs = 0, totalContacts = 0, totalMoved = 0;
+    
+    for (int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < objectCount; i++) {
+            objects[i]->position += velocities[i] * deltaTime;
+            objects[i]->rotation += spins[i] * deltaTime;
+            for (int axis = 0; axis < 3; axis++) {
+                if (glm::abs(objects[i]->position[axis]) > roomSize * 0.5f) velocities[i][axis] = -velocities[i][axis];
+            }
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        totalMoved += broadphase.Update();
+        updateTime += MillisecondsSince(start);
+        
+        start = std::chrono::steady_clock::now();
+        std::vector<CollisionQuery> pairs = broadphase.FindPairs();
+        pairTime += MillisecondsSince(start);
+        
+        start = std::chrono::steady_clock::now();
+        std::vector<CollisionResult> results = narrowPhase.Query(pairs);
+        narrowTime += MillisecondsSince(start);
+        
+        totalPairs += pairs.size();
+        for (const CollisionResult& result : results) {
+            totalContacts += result.intersecting;
+        }
+    }
+    
+    std::cout << "broadphase benchmark: " << objectCount << " objects, " << frames << " frames, " << threadPool.Size() << " threads\n";
+    std::cout << "  update      " << updateTime / frames << " ms/frame (" << totalMoved / frames << " reinserted, tree height " << broadphase.GetTreeHeight() << ")\n";
+    std::cout << "  find pairs  " << pairTime / frames << " ms/frame (" << totalPairs / frames << " pairs)\n";
+    std::cout << "  narrow      " << narrowTime / frames << " ms/frame (" << totalContacts / frames << " contacts)\n";
+    
+    for (RObject* object : objects) {
+        delete object;
+    }
+}
+
+#endif /* benchmark_h */
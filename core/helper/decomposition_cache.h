@@ -0,0 +1,74 @@
+//
+//  decomposition_cache.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef decomposition_cache_h
+#define decomposition_cache_h
+
+#include <cstdio>
+
+// Clusters an asset is decomposed to, by Model::Load and the farm alike
+#define ACD_ASSET_MAX_CLUSTERS 1000
+
+// Where Model::Load looks for hulls the farm decomposed ahead of time; empty turns the lookup off.
+std::string decompositionCacheDirectory;
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Cache //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Decomposition cache entry of an asset: a hull blob named after a hash of the asset's path, size and
+// modification time and of the parameters that shape its hulls. An edited asset or a change of parameters
+// then misses the cache and is decomposed again; the entry it had is left behind unused.
+std::string GetDecompositionCachePath(const std::string& cacheDirectory, const std::string& assetPath) {
+    
+    struct stat status{};
+    stat(assetPath.c_str(), &status);
+    
+    std::string key = assetPath;
+    for (long long value : {(long long)status.st_size, (long long)status.st_mtime, (long long)ACD_ASSET_MAX_CLUSTERS,
+                            (long long)ACD_MAX_HULL_VERTICES, (long long)ACD_MAX_HULL_FACES, (long long)HULL_BLOB_VERSION}) {
+        key += "\n" + std::to_string(value);
+    }
+    key += "\n" + std::to_string(ACD_CONCAVITY_THRESHOLD);
+    
+    uint64_t hash = 1469598103934665603ull;
+    for (char c : key) {
+        hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+    }
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+    return cacheDirectory + "/" + name + ".hulls";
+}
+
+// Written next to path and renamed over it, so readers and a requeued job never see half a blob.
+void SaveDecompositionCache(const std::string& path, const std::vector<ConvexHull>& hulls) {
+    
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    if (!HullBlob::Create(hulls).Save(temporary) || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Couldn't write " + path);
+    }
+}
+
+// The cached hulls of assetPath, or false when decompositionCacheDirectory is unset or has no entry for it.
+bool LoadDecompositionCache(const std::string& assetPath, std::vector<ConvexHull>& hulls) {
+    
+    if (decompositionCacheDirectory.empty()) return false;
+    
+    HullBlob blob;
+    if (!blob.Load(GetDecompositionCachePath(decompositionCacheDirectory, assetPath))) return false;
+    
+    hulls.resize(blob.GetHullCount());
+    for (size_t i = 0; i < hulls.size(); i++) {
+        hulls[i] = blob.Decode(i);
+    }
+    return true;
+}
+
+#endif /* decomposition_cache_h */
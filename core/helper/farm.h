@@ -0,0 +1,553 @@
+//
+//  farm.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef farm_h
+#define farm_h
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <sys/file.h>
+#include <sys/wait.h>
+
+#define FARM_QUEUE_MAGIC 0x4D524146u
+#define FARM_PATH_LENGTH 1024
+#define FARM_BRICK_TRIANGLES 50000
+#define FARM_MAX_BRICKS 64
+#define FARM_MAX_ATTEMPTS 3
+#define FARM_POLL_MICROSECONDS 20000
+
+typedef enum farmJobKind {
+    FARM_JOB_ASSET,
+    FARM_JOB_BRICK,
+    FARM_JOB_MERGE
+} FarmJobKind;
+
+typedef enum farmJobState {
+    FARM_JOB_EMPTY,
+    FARM_JOB_PENDING,
+    FARM_JOB_RUNNING,
+    FARM_JOB_DONE,
+    FARM_JOB_FAILED
+} FarmJobState;
+
+// One slot of the queue. status packs the state into the low byte and the pid of the worker running the
+// job above it, so claiming a job and recording who holds it is a single compare-and-swap and a crash can
+// never leave a running job without an owner. Everything else is written before the job is published as
+// pending and not touched while it runs, except attempts, which only the driver changes.
+//
+// An asset over FARM_BRICK_TRIANGLES is cut into bricks, each a job of its own, and the slot after the last
+// brick is kept for the merge that the driver publishes once every brick has finished.
+typedef struct farmJob {
+    std::atomic<uint64_t> status;
+    int32_t kind;
+    int32_t attempts;
+    int32_t parent;
+    int32_t firstBrick, brickCount;
+    char path[FARM_PATH_LENGTH];
+} FarmJob;
+
+// unfinished counts the jobs that are neither done nor failed. A split asset hands its own count on to its
+// merge, so unfinished reaches zero only when there is nothing left to do and workers can leave. Every job
+// below finishedPrefix is done or failed, states it never leaves, so claims start looking there. Every
+// worker runs under the driver's memory budget, and tracks and reports its memory if the driver does.
+typedef struct farmQueueHeader {
+    uint32_t magic;
+    uint32_t capacity;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> unfinished;
+    std::atomic<uint32_t> finishedPrefix;
+    uint64_t memoryBudget;
+    uint32_t trackMemory;
+    char cacheDirectory[FARM_PATH_LENGTH];
+} FarmQueueHeader;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the farm queue is shared between processes and needs address-free atomics");
+
+inline uint64_t FarmStatus(FarmJobState state, pid_t worker) { return ((uint64_t)(uint32_t)worker << 8) | (uint64_t)state; }
+inline FarmJobState GetFarmJobState(uint64_t status) { return (FarmJobState)(status & 0xFF); }
+inline pid_t GetFarmJobWorker(uint64_t status) { return (pid_t)(uint32_t)(status >> 8); }
+
+// The job queue of a decomposition farm: a file in the cache directory mapped shared into the driver and
+// every worker. The workers are separate processes, so a crash takes down one job rather than the farm.
+class FarmQueue {
+public:
+    FarmQueue() = default;
+    FarmQueue(const FarmQueue&) = delete;
+    FarmQueue& operator=(const FarmQueue&) = delete;
+    ~FarmQueue();
+    
+    bool Create(const std::string& path, const std::string& cacheDirectory, uint32_t capacity);
+    bool Open(const std::string& path);
+    
+    FarmQueueHeader& GetHeader() const { return *header; }
+    FarmJob& GetJob(int32_t job) const { return jobs[job]; }
+    uint32_t Count() const { return std::min(header->count.load(), header->capacity); }
+    
+    int32_t Reserve(uint32_t slots);
+    void Publish(int32_t job, bool counted);
+    int32_t Claim(pid_t worker);
+    void Finish(int32_t job, bool succeeded);
+    
+private:
+    FarmQueueHeader* header = nullptr;
+    FarmJob* jobs = nullptr;
+    size_t size = 0;
+    int lockFile = -1;
+    
+    bool Map(int file, size_t mappingSize);
+};
+
+FarmQueue::~FarmQueue() {
+    if (header) munmap((void*)header, size);
+    if (lockFile >= 0) close(lockFile);
+}
+
+bool FarmQueue::Map(int file, size_t mappingSize) {
+    
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapping == MAP_FAILED) return false;
+    
+    header = (FarmQueueHeader*)mapping;
+    jobs = (FarmJob*)((char*)mapping + sizeof(FarmQueueHeader));
+    size = mappingSize;
+    return true;
+}
+
+// A fresh file reads as zeros, which is an empty header and capacity empty jobs. The driver holds a lock
+// on the file for as long as it runs, so a second farm on the same cache fails here instead of wiping the
+// queue under the first; a queue left behind by a driver that died is simply started over.
+bool FarmQueue::Create(const std::string& path, const std::string& cacheDirectory, uint32_t capacity) {
+    
+    if (cacheDirectory.size() >= FARM_PATH_LENGTH) return false;
+    
+    int file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) return false;
+    
+    size_t mappingSize = sizeof(FarmQueueHeader) + (size_t)capacity * sizeof(FarmJob);
+    if (flock(file, LOCK_EX | LOCK_NB) != 0 || ftruncate(file, 0) != 0 || ftruncate(file, (off_t)mappingSize) != 0 || !Map(file, mappingSize)) {
+        close(file);
+        return false;
+    }
+    lockFile = file;
+    header->magic = FARM_QUEUE_MAGIC;
+    header->capacity = capacity;
+    header->memoryBudget = memoryStats.budget;
+    header->trackMemory = memoryStats.tracking.load();
+    std::memcpy(header->cacheDirectory, cacheDirectory.c_str(), cacheDirectory.size() + 1);
+    return true;
+}
+
+bool FarmQueue::Open(const std::string& path) {
+    
+    int file = open(path.c_str(), O_RDWR);
+    if (file < 0) return false;
+    
+    struct stat status;
+    bool mapped = fstat(file, &status) == 0 && (size_t)status.st_size >= sizeof(FarmQueueHeader) && Map(file, (size_t)status.st_size);
+    close(file);
+    if (!mapped) return false;
+    return header->magic == FARM_QUEUE_MAGIC && sizeof(FarmQueueHeader) + (size_t)header->capacity * sizeof(FarmJob) <= size;
+}
+
+// First of slots consecutive empty jobs, or -1 when the queue is full.
+int32_t FarmQueue::Reserve(uint32_t slots) {
+    
+    uint32_t first = header->count.fetch_add(slots);
+    if ((uint64_t)first + slots > header->capacity) return -1;
+    return (int32_t)first;
+}
+
+// counted is false for a merge, which inherits the unfinished count of its split asset.
+void FarmQueue::Publish(int32_t job, bool counted) {
+    
+    if (counted) header->unfinished.fetch_add(1);
+    jobs[job].status.store(FarmStatus(FARM_JOB_PENDING, 0));
+}
+
+// Jobs are read before any compare-and-swap, so a claim writes to no slot but the one it takes, and the
+// scan skips the finished prefix, moving it up over any jobs it finds finished at its end.
+int32_t FarmQueue::Claim(pid_t worker) {
+    
+    uint32_t count = Count();
+    bool prefix = true;
+    for (uint32_t i = header->finishedPrefix.load(); i < count; i++) {
+        uint64_t status = jobs[i].status.load();
+        FarmJobState state = GetFarmJobState(status);
+        
+        if (prefix && (state == FARM_JOB_DONE || state == FARM_JOB_FAILED)) {
+            uint32_t expected = i;
+            if (header->finishedPrefix.load() == i) header->finishedPrefix.compare_exchange_strong(expected, i + 1);
+            continue;
+        }
+        prefix = false;
+        
+        if (state == FARM_JOB_PENDING && jobs[i].status.compare_exchange_strong(status, FarmStatus(FARM_JOB_RUNNING, worker))) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+// A split asset is done but still unfinished: its merge finishes it.
+void FarmQueue::Finish(int32_t job, bool succeeded) {
+    
+    FarmJob& finished = jobs[job];
+    bool split = succeeded && finished.kind == FARM_JOB_ASSET && finished.brickCount > 0;
+    finished.status.store(FarmStatus(succeeded ? FARM_JOB_DONE : FARM_JOB_FAILED, 0));
+    if (!split) header->unfinished.fetch_sub(1);
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Bricks //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Cuts the triangles of meshes into bricks of at most maxTriangles by median splits along the longest axis
+// of their centroids, so every brick is compact and can be decomposed on its own. Pieces never cross a
+// brick boundary, which is the price of decomposing one asset on several workers.
+std::vector<Mesh> SplitIntoBricks(const std::vector<Mesh>& meshes, size_t maxTriangles) {
+    
+    typedef struct brickTriangle {
+        glm::vec3 centroid;
+        uint32_t mesh, triangle;
+    } BrickTriangle;
+    
+    std::vector<BrickTriangle> triangles;
+    for (uint32_t m = 0; m < meshes.size(); m++) {
+        const Mesh& mesh = meshes[m];
+        for (uint32_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            glm::vec3 centroid = MeshLayout::Position(mesh.vertices.data(), mesh.indices[t]) +
+                                 MeshLayout::Position(mesh.vertices.data(), mesh.indices[t + 1]) +
+                                 MeshLayout::Position(mesh.vertices.data(), mesh.indices[t + 2]);
+            triangles.push_back(BrickTriangle{centroid / 3.0f, m, t});
+        }
+    }
+    maxTriangles = std::max(maxTriangles, (triangles.size() + FARM_MAX_BRICKS - 1) / FARM_MAX_BRICKS);
+    
+    std::vector<std::pair<size_t, size_t>> ranges;
+    std::vector<std::pair<size_t, size_t>> stack = {{0, triangles.size()}};
+    while (!stack.empty()) {
+        auto [begin, end] = stack.back();
+        stack.pop_back();
+        if (end - begin <= maxTriangles) {
+            if (end > begin) ranges.push_back({begin, end});
+            continue;
+        }
+        
+        glm::vec3 boundsMin = triangles[begin].centroid, boundsMax = boundsMin;
+        for (size_t i = begin; i < end; i++) {
+            boundsMin = glm::min(boundsMin, triangles[i].centroid);
+            boundsMax = glm::max(boundsMax, triangles[i].centroid);
+        }
+        glm::vec3 extent = boundsMax - boundsMin;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+                         [axis](const BrickTriangle& a, const BrickTriangle& b) { return a.centroid[axis] < b.centroid[axis]; });
+        stack.push_back({middle, end});
+        stack.push_back({begin, middle});
+    }
+    
+    std::vector<Mesh> bricks(ranges.size());
+    threadPool.ParallelFor(ranges.size(), 1, [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; b++) {
+            Mesh& brick = bricks[b];
+            std::unordered_map<uint64_t, uint32_t> remap;
+            for (size_t i = ranges[b].first; i < ranges[b].second; i++) {
+                const Mesh& mesh = meshes[triangles[i].mesh];
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t index = mesh.indices[triangles[i].triangle + corner];
+                    auto [it, inserted] = remap.try_emplace(((uint64_t)triangles[i].mesh << 32) | index, (uint32_t)MeshLayout::Count(brick.vertices));
+                    if (inserted) {
+                        const float* vertex = &mesh.vertices[index * MeshLayout::stride];
+                        brick.vertices.insert(brick.vertices.end(), vertex, vertex + MeshLayout::stride);
+                    }
+                    brick.indices.push_back(it->second);
+                }
+            }
+        }
+    });
+    return bricks;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// RunFarmWorker //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Brick files live next to the asset's cache entry and are named after their job, so a requeued split
+// never overwrites bricks an earlier attempt already handed out.
+std::string GetBrickPath(const std::string& cachePath, int32_t job, const std::string& extension) {
+    return cachePath.substr(0, cachePath.size() - 6) + "." + std::to_string(job) + extension;
+}
+
+// Publishes the bricks of job as jobs of their own. False when the queue has no room, and the asset is
+// then decomposed in one piece.
+bool SplitFarmJob(FarmQueue& queue, int32_t job, const std::string& cachePath, const std::vector<Mesh>& bricks) {
+    
+    int32_t first = queue.Reserve((uint32_t)bricks.size() + 1);
+    if (first < 0) return false;
+    
+    for (size_t i = 0; i < bricks.size(); i++) {
+        int32_t slot = first + (int32_t)i;
+        std::string brickPath = GetBrickPath(cachePath, slot, ".ply");
+        if (brickPath.size() >= FARM_PATH_LENGTH || !SaveBinaryPLY(brickPath, bricks[i])) {
+            throw std::runtime_error("Couldn't write " + brickPath);
+        }
+    }
+    
+    FarmJob& asset = queue.GetJob(job);
+    for (size_t i = 0; i <= bricks.size(); i++) {
+        int32_t slot = first + (int32_t)i;
+        FarmJob& brick = queue.GetJob(slot);
+        std::string path = i < bricks.size() ? GetBrickPath(cachePath, slot, ".ply") : std::string(asset.path);
+        brick.kind = i < bricks.size() ? FARM_JOB_BRICK : FARM_JOB_MERGE;
+        brick.parent = job;
+        std::memcpy(brick.path, path.c_str(), path.size() + 1);
+        if (i < bricks.size()) queue.Publish(slot, true);
+    }
+    asset.firstBrick = first;
+    asset.brickCount = (int32_t)bricks.size();
+    return true;
+}
+
+void RunFarmJob(FarmQueue& queue, int32_t job) {
+    
+    FarmJob& current = queue.GetJob(job);
+    std::string cacheDirectory = queue.GetHeader().cacheDirectory;
+    
+    if (current.kind == FARM_JOB_ASSET) {
+        current.brickCount = 0;
+        std::string cachePath = GetDecompositionCachePath(cacheDirectory, current.path);
+        std::shared_ptr<Model> model = Model::ImportFile(current.path);
+        
+        size_t triangleCount = 0;
+        for (const Mesh& mesh : model->meshes) triangleCount += mesh.indices.size() / 3;
+        if (triangleCount > FARM_BRICK_TRIANGLES) {
+            std::vector<Mesh> bricks = SplitIntoBricks(model->meshes, FARM_BRICK_TRIANGLES);
+            if (bricks.size() > 1 && SplitFarmJob(queue, job, cachePath, bricks)) {
+                std::cout << current.path << ": " << triangleCount << " triangles split into " << bricks.size() << " bricks\n";
+                return;
+            }
+        }
+        
+        std::vector<ConvexHull> hulls = model->ComputeDecomposition(ACD_ASSET_MAX_CLUSTERS);
+        SaveDecompositionCache(cachePath, hulls);
+        std::cout << current.path << ": " << hulls.size() << " pieces\n";
+    }
+    else if (current.kind == FARM_JOB_BRICK) {
+        std::optional<Mesh> mesh = LoadMeshFile(current.path);
+        if (!mesh) throw std::runtime_error(std::string("Couldn't load brick ") + current.path);
+        
+        RObject brick;
+        brick.meshes.push_back(std::move(*mesh));
+        brick.SetHullBudget(ACD_MAX_HULL_VERTICES, ACD_MAX_HULL_FACES, 0.0f);
+        
+        std::string path = current.path;
+        SaveDecompositionCache(path.substr(0, path.size() - 4) + ".hulls", brick.ComputeDecomposition(ACD_ASSET_MAX_CLUSTERS));
+    }
+    else {
+        const FarmJob& asset = queue.GetJob(current.parent);
+        std::string cachePath = GetDecompositionCachePath(cacheDirectory, asset.path);
+        
+        std::vector<ConvexHull> hulls;
+        for (int32_t brick = asset.firstBrick; brick < asset.firstBrick + asset.brickCount; brick++) {
+            HullBlob blob;
+            if (GetFarmJobState(queue.GetJob(brick).status.load()) != FARM_JOB_DONE || !blob.Load(GetBrickPath(cachePath, brick, ".hulls"))) {
+                throw std::runtime_error(std::string("Brick ") + std::to_string(brick) + " of " + asset.path + " has no result");
+            }
+            for (size_t i = 0; i < blob.GetHullCount(); i++) hulls.push_back(blob.Decode(i));
+        }
+        SaveDecompositionCache(cachePath, hulls);
+        
+        for (int32_t brick = asset.firstBrick; brick < asset.firstBrick + asset.brickCount; brick++) {
+            std::remove(GetBrickPath(cachePath, brick, ".ply").c_str());
+            std::remove(GetBrickPath(cachePath, brick, ".hulls").c_str());
+        }
+        std::cout << asset.path << ": " << hulls.size() << " pieces from " << asset.brickCount << " bricks\n";
+    }
+}
+
+// Takes jobs until none is left unfinished. A job that throws fails for good, since importing or
+// decomposing the same input again would throw again; only a crash earns a job another attempt.
+int RunFarmWorker(const std::string& queuePath) {
+    
+    FarmQueue queue;
+    if (!queue.Open(queuePath)) {
+        std::cerr << "couldn't open farm queue " << queuePath << "\n";
+        return 1;
+    }
+    
+    SetMemoryBudget((size_t)queue.GetHeader().memoryBudget);
+    if (queue.GetHeader().trackMemory) StartMemoryTracking();
+    
+    pid_t self = getpid();
+    while (true) {
+        int32_t job = queue.Claim(self);
+        if (job < 0) {
+            if (queue.GetHeader().unfinished.load() > 0) {
+                usleep(FARM_POLL_MICROSECONDS);
+                continue;
+            }
+            if (memoryStats.tracking.load()) {
+                std::cout << "farm worker " << self << " ";
+                PrintMemoryReport(std::cout);
+            }
+            return 0;
+        }
+        
+        bool succeeded = true;
+        try {
+            RunFarmJob(queue, job);
+        }
+        catch (const std::exception& error) {
+            std::cerr << "farm job " << job << " failed: " << error.what() << "\n";
+            succeeded = false;
+        }
+        queue.Finish(job, succeeded);
+    }
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// RunDecompositionFarm //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Runs the driver's own binary again. argv[0] has no directory when the binary was found through PATH, so
+// it is only the fallback where /proc/self/exe is missing, and is then looked up in PATH as the shell did.
+pid_t SpawnFarmWorker(const std::string& executable, const std::string& queuePath) {
+    
+    pid_t worker = fork();
+    if (worker == 0) {
+        char* const arguments[] = {(char*)executable.c_str(), (char*)"--farm-worker", (char*)queuePath.c_str(), nullptr};
+#if defined(__linux__)
+        execv("/proc/self/exe", arguments);
+#endif
+        execvp(executable.c_str(), arguments);
+        _exit(127);
+    }
+    return worker;
+}
+
+// Decomposes assets into cacheDirectory on workerCount local processes, each the executable started again
+// with --farm-worker. Assets that already have a cache entry are skipped. A worker that crashes has its
+// jobs put back, up to FARM_MAX_ATTEMPTS times each, and is replaced while work remains. Returns the
+// number of assets left without a cache entry.
+int RunDecompositionFarm(const std::string& executable, int workerCount, const std::string& cacheDirectory, const std::vector<std::string>& assets) {
+    
+    mkdir(cacheDirectory.c_str(), 0755);
+    
+    std::vector<std::string> pending;
+    for (const std::string& asset : assets) {
+        if (access(GetDecompositionCachePath(cacheDirectory, asset).c_str(), F_OK) == 0) std::cout << asset << ": cached\n";
+        else pending.push_back(asset);
+    }
+    if (pending.empty()) return 0;
+    
+    // Every attempt at an asset may split it again into fresh slots
+    std::string queuePath = cacheDirectory + "/farm.queue";
+    FarmQueue queue;
+    if (!queue.Create(queuePath, cacheDirectory, (uint32_t)pending.size() * (1 + FARM_MAX_ATTEMPTS * (FARM_MAX_BRICKS + 1)))) {
+        throw std::runtime_error("Couldn't create farm queue " + queuePath + "; is another farm using this cache?");
+    }
+    int32_t first = queue.Reserve((uint32_t)pending.size());
+    for (size_t i = 0; i < pending.size(); i++) {
+        FarmJob& job = queue.GetJob(first + (int32_t)i);
+        job.kind = FARM_JOB_ASSET;
+        std::snprintf(job.path, FARM_PATH_LENGTH, "%s", pending[i].c_str());
+        queue.Publish(first + (int32_t)i, true);
+    }
+    
+    std::vector<pid_t> workers;
+    workerCount = std::max(workerCount, 1);
+    for (int i = 0; i < workerCount; i++) {
+        pid_t worker = SpawnFarmWorker(executable, queuePath);
+        if (worker > 0) workers.push_back(worker);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    size_t crashes = 0;
+    bool launchFailed = workers.empty();
+    
+    while (!workers.empty()) {
+        int status = 0;
+        pid_t exited;
+        while ((exited = waitpid(-1, &status, WNOHANG)) > 0) {
+            workers.erase(std::remove(workers.begin(), workers.end(), exited), workers.end());
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+            
+            // A worker that exits with an error never got going (exec or the queue failed) and would
+            // fail again; one killed by a signal crashed inside a job
+            if (WIFSIGNALED(status)) {
+                crashes++;
+                std::cerr << "farm worker " << exited << " died on signal " << WTERMSIG(status) << "\n";
+            }
+            else launchFailed = true;
+            
+            for (uint32_t i = 0; i < queue.Count(); i++) {
+                FarmJob& job = queue.GetJob((int32_t)i);
+                uint64_t running = job.status.load();
+                if (GetFarmJobState(running) != FARM_JOB_RUNNING || GetFarmJobWorker(running) != exited) continue;
+                
+                if (++job.attempts < FARM_MAX_ATTEMPTS) {
+                    job.status.store(FarmStatus(FARM_JOB_PENDING, 0));
+                }
+                else {
+                    std::cerr << "farm job " << i << " (" << job.path << ") failed after " << job.attempts << " attempts\n";
+                    job.brickCount = 0;
+                    queue.Finish((int32_t)i, false);
+                }
+            }
+            if (queue.GetHeader().unfinished.load() > 0 && !launchFailed) {
+                pid_t worker = SpawnFarmWorker(executable, queuePath);
+                if (worker > 0) workers.push_back(worker);
+            }
+        }
+        
+        // Merges are published here rather than by the last brick, so a worker dying halfway through
+        // finishing a brick can't lose or duplicate one
+        for (uint32_t i = 0; i < queue.Count(); i++) {
+            FarmJob& asset = queue.GetJob((int32_t)i);
+            if (asset.kind != FARM_JOB_ASSET || asset.brickCount == 0 || GetFarmJobState(asset.status.load()) != FARM_JOB_DONE) continue;
+            
+            int32_t merge = asset.firstBrick + asset.brickCount;
+            if (GetFarmJobState(queue.GetJob(merge).status.load()) != FARM_JOB_EMPTY) continue;
+            
+            bool bricksFinished = true;
+            for (int32_t brick = asset.firstBrick; brick < merge && bricksFinished; brick++) {
+                FarmJobState state = GetFarmJobState(queue.GetJob(brick).status.load());
+                bricksFinished = state == FARM_JOB_DONE || state == FARM_JOB_FAILED;
+            }
+            if (bricksFinished) queue.Publish(merge, false);
+        }
+        
+        if (launchFailed) {
+            for (pid_t worker : workers) kill(worker, SIGTERM);
+            for (pid_t worker : workers) waitpid(worker, nullptr, 0);
+            workers.clear();
+            std::cerr << "couldn't start farm workers from " << executable << "\n";
+        }
+        else usleep(FARM_POLL_MICROSECONDS);
+    }
+    std::remove(queuePath.c_str());
+    
+    int missing = 0;
+    for (const std::string& asset : assets) {
+        if (access(GetDecompositionCachePath(cacheDirectory, asset).c_str(), F_OK) != 0) missing++;
+    }
+    std::cout << "farm: " << assets.size() - missing << "/" << assets.size() << " assets decomposed on " << workerCount
+              << " workers in " << MillisecondsSince(start) << " ms, " << crashes << " worker crashes\n";
+    return missing;
+}
+
+#endif /* farm_h */
@@ -0,0 +1,136 @@
+//
+//  frustum.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef frustum_h
+#define frustum_h
+
+#include <cfloat>
+
+#define FRUSTUM_PARALLEL_THRESHOLD 4096
+
+// Six planes (normal, offset) with the inside on the positive side: left, right, bottom, top, near, far.
+typedef struct frustum {
+    glm::vec4 planes[6];
+} Frustum;
+
+// Boxes in structure-of-arrays form, padded to a multiple of 4 with empty boxes so the culling loop
+// always works on whole vectors.
+typedef struct boundsArray {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+    size_t count = 0;
+} BoundsArray;
+
+// What the culling passes of the current frame saw; reset once per frame.
+typedef struct cullingStats {
+    size_t visible;
+    size_t culled;
+} CullingStats;
+
+CullingStats cullingStats;
+
+// Gribb-Hartmann: the planes are sums and differences of the rows of the view-projection matrix.
+Frustum ExtractFrustum(const glm::mat4& viewProjection) {
+    
+    glm::vec4 rowX = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    glm::vec4 rowY = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    glm::vec4 rowZ = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    glm::vec4 rowW = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+    
+    Frustum frustum;
+    frustum.planes[0] = rowW + rowX;
+    frustum.planes[1] = rowW - rowX;
+    frustum.planes[2] = rowW + rowY;
+    frustum.planes[3] = rowW - rowY;
+    frustum.planes[4] = rowW + rowZ;
+    frustum.planes[5] = rowW - rowZ;
+    return frustum;
+}
+
+// The same frustum in the local space of an object, so its boxes are tested without transforming them.
+Frustum TransformFrustum(const Frustum& frustum, const glm::mat4& transform) {
+    
+    Frustum local;
+    glm::mat4 transposed = glm::transpose(transform);
+    for (int i = 0; i < 6; i++) {
+        local.planes[i] = transposed * frustum.planes[i];
+    }
+    return local;
+}
+
+BoundsArray CreateBoundsArray(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax) {
+    
+    BoundsArray bounds;
+    bounds.count = boundsMin.size();
+    size_t padded = (bounds.count + 3) & ~(size_t)3;
+    
+    // Padding boxes are inverted, so they fail every plane
+    bounds.minX.assign(padded, FLT_MAX);
+    bounds.minY.assign(padded, FLT_MAX);
+    bounds.minZ.assign(padded, FLT_MAX);
+    bounds.maxX.assign(padded, -FLT_MAX);
+    bounds.maxY.assign(padded, -FLT_MAX);
+    bounds.maxZ.assign(padded, -FLT_MAX);
+    for (size_t i = 0; i < bounds.count; i++) {
+        bounds.minX[i] = boundsMin[i].x;
+        bounds.minY[i] = boundsMin[i].y;
+        bounds.minZ[i] = boundsMin[i].z;
+        bounds.maxX[i] = boundsMax[i].x;
+        bounds.maxY[i] = boundsMax[i].y;
+        bounds.maxZ[i] = boundsMax[i].z;
+    }
+    return bounds;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// CullBounds //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// visible[i] is set to 1 for every box that is at least partly inside the frustum. Tests four boxes at a
+// time: for each plane only the corner furthest along its normal matters, and which of min/max that is
+// depends on the plane alone, so every plane is three multiply-adds over whole columns. Conservative, like
+// any box-plane test: a box near a frustum corner can pass while lying outside.
+void CullBounds(const Frustum& frustum, const BoundsArray& bounds, std::vector<uint8_t>& visible) {
+    
+    visible.resize(bounds.minX.size());
+    
+    auto cull = [&](size_t begin, size_t end) {
+        float4 zero = Float4Set(0.0f);
+        for (size_t i = begin * 4; i < end * 4; i += 4) {
+            int outside = 0;
+            for (const glm::vec4& plane : frustum.planes) {
+                float4 x = Float4Load(plane.x > 0.0f ? &bounds.maxX[i] : &bounds.minX[i]);
+                float4 y = Float4Load(plane.y > 0.0f ? &bounds.maxY[i] : &bounds.minY[i]);
+                float4 z = Float4Load(plane.z > 0.0f ? &bounds.maxZ[i] : &bounds.minZ[i]);
+                
+                float4 distance = Float4Add(Float4Mul(x, Float4Set(plane.x)), Float4Set(plane.w));
+                distance = Float4Add(distance, Float4Mul(y, Float4Set(plane.y)));
+                distance = Float4Add(distance, Float4Mul(z, Float4Set(plane.z)));
+                outside |= Float4MoveMask(Float4Greater(zero, distance));
+                if (outside == 0xF) break;
+            }
+            for (int lane = 0; lane < 4; lane++) {
+                visible[i + lane] = (outside >> lane & 1) == 0;
+            }
+        }
+    };
+    
+    size_t groups = bounds.minX.size() / 4;
+    if (bounds.count >= FRUSTUM_PARALLEL_THRESHOLD) threadPool.ParallelFor(groups, 256, cull);
+    else cull(0, groups);
+    
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < bounds.count; i++) {
+        visibleCount += visible[i];
+    }
+    cullingStats.visible += visibleCount;
+    cullingStats.culled += bounds.count - visibleCount;
+}
+
+#endif /* frustum_h */
@@ -0,0 +1,58 @@
+//
+//  mapped_file.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef mapped_file_h
+#define mapped_file_h
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Read-only view of a whole file. Pages fault in on first touch, so chunks can be parsed out of order.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+    
+    bool Open(const std::string& path);
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+    
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+bool MappedFile::Open(const std::string& path) {
+    
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        close(file);
+        return false;
+    }
+    
+    void* mapping = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED) return false;
+    
+    madvise(mapping, (size_t)status.st_size, MADV_WILLNEED);
+    data = (const char*)mapping;
+    size = (size_t)status.st_size;
+    return true;
+}
+
+MappedFile::~MappedFile() {
+    if (data) munmap((void*)data, size);
+}
+
+#endif /* mapped_file_h */
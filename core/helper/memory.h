@@ -0,0 +1,185 @@
+//
+//  memory.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef memory_h
+#define memory_h
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define ACD_USABLE_SIZE(block) malloc_size(block)
+#else
+#include <malloc.h>
+#define ACD_USABLE_SIZE(block) malloc_usable_size(block)
+#endif
+
+typedef enum memoryStage {
+    MEMORY_STAGE_OTHER,
+    MEMORY_STAGE_IMPORT,
+    MEMORY_STAGE_ADJACENCY,
+    MEMORY_STAGE_CLUSTERING,
+    MEMORY_STAGE_HULLS,
+    MEMORY_STAGE_UPLOAD,
+    MEMORY_STAGE_COUNT
+} MemoryStage;
+
+const char* memoryStageNames[MEMORY_STAGE_COUNT] = {"other", "import", "adjacency", "clustering", "hulls", "upload"};
+
+// What the allocations made under one stage did. peak is the highest live byte count of the whole process
+// seen while the stage was allocating, so the stage with the highest peak is the one to blame for an OOM.
+typedef struct memoryStageStats {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> allocatedBytes;
+    std::atomic<uint64_t> freedBytes;
+    std::atomic<int64_t> peakBytes;
+} MemoryStageStats;
+
+// Counted by the replaced operator new / delete below, which cost one relaxed load while tracking is off.
+// Blocks are measured by their usable size, so nothing is added to them and blocks allocated before
+// tracking began can still be freed. budget, when set, is what Decompose has to stay under; splitMeshes
+// counts the meshes it had to cluster region by region to do so, and clusteringRegions their regions.
+typedef struct memoryStats {
+    std::atomic<bool> tracking;
+    std::atomic<int64_t> liveBytes;
+    std::atomic<int64_t> peakBytes;
+    size_t budget;
+    std::atomic<uint64_t> splitMeshes;
+    std::atomic<uint64_t> clusteringRegions;
+    MemoryStageStats stages[MEMORY_STAGE_COUNT];
+} MemoryStats;
+
+MemoryStats memoryStats;
+thread_local MemoryStage currentMemoryStage = MEMORY_STAGE_OTHER;
+
+// Charges the allocations of the current thread to stage until the scope ends. Thread pool chunks run
+// under the stage of the thread that called ParallelFor.
+class MemoryStageScope {
+public:
+    MemoryStageScope(MemoryStage stage) : previous(currentMemoryStage) { currentMemoryStage = stage; }
+    ~MemoryStageScope() { currentMemoryStage = previous; }
+    MemoryStageScope(const MemoryStageScope&) = delete;
+    MemoryStageScope& operator=(const MemoryStageScope&) = delete;
+    
+private:
+    MemoryStage previous;
+};
+
+inline void RaiseMemoryPeak(std::atomic<int64_t>& peak, int64_t value) {
+    int64_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+inline void TrackAllocation(void* block) {
+    
+    size_t size = ACD_USABLE_SIZE(block);
+    MemoryStageStats& stage = memoryStats.stages[currentMemoryStage];
+    stage.allocations.fetch_add(1, std::memory_order_relaxed);
+    stage.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    
+    int64_t live = memoryStats.liveBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+    RaiseMemoryPeak(memoryStats.peakBytes, live);
+    RaiseMemoryPeak(stage.peakBytes, live);
+}
+
+inline void TrackFree(void* block) {
+    
+    size_t size = ACD_USABLE_SIZE(block);
+    memoryStats.stages[currentMemoryStage].freedBytes.fetch_add(size, std::memory_order_relaxed);
+    memoryStats.liveBytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+}
+
+void StartMemoryTracking() {
+    memoryStats.tracking.store(true);
+}
+
+// A budget needs live byte counts, so setting one starts tracking as well.
+void SetMemoryBudget(size_t bytes) {
+    memoryStats.budget = bytes;
+    if (bytes > 0) StartMemoryTracking();
+}
+
+// Bytes that may still be allocated before the budget is hit; SIZE_MAX without a budget.
+size_t GetMemoryHeadroom() {
+    
+    if (memoryStats.budget == 0) return SIZE_MAX;
+    int64_t live = std::max<int64_t>(memoryStats.liveBytes.load(), 0);
+    return (size_t)std::max<int64_t>((int64_t)memoryStats.budget - live, 0);
+}
+
+void PrintMemoryReport(std::ostream& output) {
+    
+    auto megabytes = [](double bytes) { return bytes / (1024.0 * 1024.0); };
+    output << "memory: peak " << megabytes((double)memoryStats.peakBytes.load()) << " MB, live " << megabytes((double)memoryStats.liveBytes.load()) << " MB\n";
+    if (memoryStats.splitMeshes.load() > 0) {
+        output << "  budget: " << memoryStats.splitMeshes.load() << " meshes clustered in " << memoryStats.clusteringRegions.load() << " regions\n";
+    }
+    for (int i = 0; i < MEMORY_STAGE_COUNT; i++) {
+        const MemoryStageStats& stage = memoryStats.stages[i];
+        if (stage.allocations.load() == 0) continue;
+        output << "  " << memoryStageNames[i] << ": " << stage.allocations.load() << " allocations, "
+               << megabytes((double)stage.allocatedBytes.load()) << " MB allocated, " << megabytes((double)stage.freedBytes.load()) << " MB freed, peak "
+               << megabytes((double)stage.peakBytes.load()) << " MB\n";
+    }
+}
+
+// The same numbers as JSON, in bytes.
+void SaveMemoryReport(std::ostream& output) {
+    
+    output << "{\n  \"peakBytes\": " << memoryStats.peakBytes.load() << ",\n  \"liveBytes\": " << memoryStats.liveBytes.load()
+           << ",\n  \"budgetBytes\": " << memoryStats.budget << ",\n  \"splitMeshes\": " << memoryStats.splitMeshes.load()
+           << ",\n  \"clusteringRegions\": " << memoryStats.clusteringRegions.load() << ",\n  \"stages\": {";
+    for (int i = 0; i < MEMORY_STAGE_COUNT; i++) {
+        const MemoryStageStats& stage = memoryStats.stages[i];
+        output << (i ? "," : "") << "\n    \"" << memoryStageNames[i] << "\": {\"allocations\": " << stage.allocations.load()
+               << ", \"allocatedBytes\": " << stage.allocatedBytes.load() << ", \"freedBytes\": " << stage.freedBytes.load()
+               << ", \"peakBytes\": " << stage.peakBytes.load() << "}";
+    }
+    output << "\n  }\n}\n";
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Global operator new / delete //
+// ------------------------------------------------------------------------------------------------------------- //
+
+void* operator new(std::size_t size) {
+    
+    void* block = std::malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    if (memoryStats.tracking.load(std::memory_order_relaxed)) TrackAllocation(block);
+    return block;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+    
+    if (!block) return;
+    if (memoryStats.tracking.load(std::memory_order_relaxed)) TrackFree(block);
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    operator delete(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept {
+    operator delete(block);
+}
+
+#endif /* memory_h */
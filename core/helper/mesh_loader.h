@@ -0,0 +1,838 @@
+//
+//  mesh_loader.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef mesh_loader_h
+#define mesh_loader_h
+
+#include <cstring>
+#include <optional>
+
+#define MESH_LOADER_CHUNK_SIZE (1 << 20)
+#define MESH_LOADER_WELD_SHARDS 64
+
+// Native loaders for the formats we ship: OBJ and binary PLY. Both write straight into MeshLayout with the
+// same post-processing Model asked Assimp for: triangulated, identical vertices joined, smooth normals when
+// the file has none, and flipped UVs.
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Number parsing //
+// ------------------------------------------------------------------------------------------------------------- //
+
+const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Eight ASCII digits are checked and converted as one 64-bit word instead of one byte at a time.
+// Assumes a little-endian host, which covers x86 and Apple silicon.
+inline bool IsEightDigits(const char* p) {
+    
+    uint64_t word;
+    memcpy(&word, p, 8);
+    return !(((word + 0x4646464646464646ull) | (word - 0x3030303030303030ull)) & 0x8080808080808080ull);
+}
+
+inline uint32_t ParseEightDigits(const char* p) {
+    
+    uint64_t word;
+    memcpy(&word, p, 8);
+    word -= 0x3030303030303030ull;
+    word = (word * 10) + (word >> 8);
+    word = (((word & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+            (((word >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    return (uint32_t)word;
+}
+
+// Decimal float with an optional exponent. Up to 19 significant digits are accumulated exactly and
+// scaled once, which is as accurate as strtof for anything an exporter writes. Advances p on success.
+bool ParseFloat(const char*& p, const char* end, float& value) {
+    
+    const char* cursor = p;
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor == '-';
+        cursor++;
+    }
+    
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    const char* digitsStart = cursor;
+    
+    while (cursor + 8 <= end && digits + 8 <= 19 && IsEightDigits(cursor)) {
+        mantissa = mantissa * 100000000 + ParseEightDigits(cursor);
+        digits += 8;
+        cursor += 8;
+    }
+    while (cursor < end && (unsigned)(*cursor - '0') < 10) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*cursor - '0');
+            digits++;
+        }
+        else {
+            exponent++;
+        }
+        cursor++;
+    }
+    bool any = cursor != digitsStart;
+    
+    if (cursor < end && *cursor == '.') {
+        cursor++;
+        const char* fractionStart = cursor;
+        while (cursor + 8 <= end && digits + 8 <= 19 && IsEightDigits(cursor)) {
+            mantissa = mantissa * 100000000 + ParseEightDigits(cursor);
+            digits += 8;
+            exponent -= 8;
+            cursor += 8;
+        }
+        while (cursor < end && (unsigned)(*cursor - '0') < 10) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*cursor - '0');
+                digits++;
+                exponent--;
+            }
+            cursor++;
+        }
+        any |= cursor != fractionStart;
+    }
+    if (!any) return false;
+    
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        const char* exponentStart = cursor++;
+        bool negativeExponent = false;
+        if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+            negativeExponent = *cursor == '-';
+            cursor++;
+        }
+        if (cursor < end && (unsigned)(*cursor - '0') < 10) {
+            int written = 0;
+            while (cursor < end && (unsigned)(*cursor - '0') < 10) {
+                if (written < 10000) written = written * 10 + (*cursor - '0');
+                cursor++;
+            }
+            exponent += negativeExponent ? -written : written;
+        }
+        else {
+            cursor = exponentStart;
+        }
+    }
+    
+    double result = (double)mantissa;
+    if (mantissa != 0) {
+        if (exponent >= 0 && exponent <= 22)        result *= exactPowersOfTen[exponent];
+        else if (exponent < 0 && exponent >= -22)   result /= exactPowersOfTen[-exponent];
+        else                                        result *= std::pow(10.0, exponent);
+    }
+    
+    value = (float)(negative ? -result : result);
+    p = cursor;
+    return true;
+}
+
+bool ParseInteger(const char*& p, const char* end, int64_t& value) {
+    
+    const char* cursor = p;
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor == '-';
+        cursor++;
+    }
+    
+    const char* digitsStart = cursor;
+    int64_t result = 0;
+    while (cursor < end && (unsigned)(*cursor - '0') < 10 && cursor - digitsStart < 18) {
+        result = result * 10 + (*cursor - '0');
+        cursor++;
+    }
+    if (cursor == digitsStart) return false;
+    
+    value = negative ? -result : result;
+    p = cursor;
+    return true;
+}
+
+inline void SkipSpaces(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+}
+
+// Area-weighted vertex normals, in place of aiProcess_GenSmoothNormals. forEachTriangle calls its
+// argument with the position indices of every triangle, so seams in uv or normal indices still share
+// one smooth normal.
+template<typename ForEachTriangle>
+std::vector<glm::vec3> ComputeSmoothNormals(const float* positions, size_t stride, size_t positionCount, ForEachTriangle forEachTriangle) {
+    
+    std::vector<glm::vec3> normals(positionCount, glm::vec3(0.0f));
+    forEachTriangle([&](uint32_t a, uint32_t b, uint32_t c) {
+        glm::vec3 pa = glm::vec3(positions[a * stride], positions[a * stride + 1], positions[a * stride + 2]);
+        glm::vec3 pb = glm::vec3(positions[b * stride], positions[b * stride + 1], positions[b * stride + 2]);
+        glm::vec3 pc = glm::vec3(positions[c * stride], positions[c * stride + 1], positions[c * stride + 2]);
+        
+        glm::vec3 normal = glm::cross(pb - pa, pc - pa);
+        normals[a] += normal;
+        normals[b] += normal;
+        normals[c] += normal;
+    });
+    
+    threadPool.ParallelFor(positionCount, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float length = glm::length(normals[i]);
+            normals[i] = length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    });
+    return normals;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// OBJ //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// One face corner as written in the file. Negative (relative) indices can only be resolved once the
+// element counts of the preceding chunks are known, so they're kept chunk-local and flagged.
+typedef struct objCorner {
+    int32_t position, uv, normal;
+    uint8_t relative;
+} ObjCorner;
+
+typedef struct objWeldKey {
+    int32_t position, uv, normal;
+} ObjWeldKey;
+
+typedef struct objChunk {
+    std::vector<float> positions, uvs, normals;
+    std::vector<ObjCorner> corners;
+    size_t positionOffset, uvOffset, normalOffset, cornerOffset;
+    bool failed;
+    
+    // Welding: the chunk's corners split by shard, and which shard each corner went to
+    std::vector<std::vector<ObjWeldKey>> shards;
+    std::vector<uint8_t> cornerShard;
+} ObjChunk;
+
+bool ParseObjIndex(const char*& p, const char* end, int32_t& index, uint8_t& relative, uint8_t bit, size_t count) {
+    
+    int64_t written;
+    if (!ParseInteger(p, end, written) || written == 0) return false;
+    
+    if (written > 0) {
+        index = (int32_t)(written - 1);
+    }
+    else {
+        index = (int32_t)((int64_t)count + written);
+        relative |= bit;
+    }
+    return true;
+}
+
+// Parses the whole lines in [begin, end). Only v, vt, vn and f matter for collision geometry; groups,
+// materials and smoothing groups are skipped, so the file comes out as a single mesh.
+void ParseObjChunk(const char* begin, const char* end, ObjChunk& chunk) {
+    
+    std::vector<ObjCorner> polygon;
+    const char* p = begin;
+    
+    while (p < end) {
+        SkipSpaces(p, end);
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+        
+        if (lineEnd - p >= 2 && p[0] == 'v') {
+            float value[3] = {0.0f, 0.0f, 0.0f};
+            int required = 3;
+            std::vector<float>* target = &chunk.positions;
+            
+            if (p[1] == ' ' || p[1] == '\t')    { p += 1; }
+            else if (p[1] == 'n')               { p += 2; target = &chunk.normals; }
+            else if (p[1] == 't')               { p += 2; target = &chunk.uvs; required = 1; }
+            else                                { target = nullptr; }
+            
+            if (target) {
+                int parsed = 0;
+                int wanted = target == &chunk.uvs ? 2 : 3;
+                for (; parsed < wanted; parsed++) {
+                    SkipSpaces(p, lineEnd);
+                    if (!ParseFloat(p, lineEnd, value[parsed])) break;
+                }
+                if (parsed < required) chunk.failed = true;
+                target->insert(target->end(), value, value + wanted);
+            }
+        }
+        else if (lineEnd - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 1;
+            polygon.clear();
+            
+            while (true) {
+                SkipSpaces(p, lineEnd);
+                if (p >= lineEnd) break;
+                
+                ObjCorner corner{-1, -1, -1, 0};
+                if (!ParseObjIndex(p, lineEnd, corner.position, corner.relative, 1, chunk.positions.size() / 3)) {
+                    chunk.failed = true;
+                    break;
+                }
+                if (p < lineEnd && *p == '/') {
+                    p++;
+                    if (p < lineEnd && *p != '/' && !ParseObjIndex(p, lineEnd, corner.uv, corner.relative, 2, chunk.uvs.size() / 2)) {
+                        chunk.failed = true;
+                        break;
+                    }
+                    if (p < lineEnd && *p == '/') {
+                        p++;
+                        if (!ParseObjIndex(p, lineEnd, corner.normal, corner.relative, 4, chunk.normals.size() / 3)) {
+                            chunk.failed = true;
+                            break;
+                        }
+                    }
+                }
+                polygon.push_back(corner);
+            }
+            
+            for (size_t i = 1; i + 1 < polygon.size(); i++) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i]);
+                chunk.corners.push_back(polygon[i + 1]);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+
+inline uint64_t HashObjCorner(int32_t position, int32_t uv, int32_t normal) {
+    
+    uint64_t hash = (uint64_t)(uint32_t)position * 0x9E3779B97F4A7C15ull;
+    hash ^= (uint64_t)(uint32_t)uv * 0xC2B2AE3D27D4EB4Full + (hash >> 29);
+    hash ^= (uint64_t)(uint32_t)normal * 0x165667B19E3779F9ull + (hash >> 32);
+    return hash ^ (hash >> 31);
+}
+
+// The file is cut into ~1 MB chunks at line breaks and parsed in parallel. Corners are then welded
+// into vertices by (position, uv, normal): each corner goes to one of MESH_LOADER_WELD_SHARDS shards
+// by hash and every shard is welded on its own, so no table is shared between threads.
+std::optional<Mesh> LoadOBJ(const char* data, size_t size) {
+    
+    const char* end = data + size;
+    std::vector<const char*> bounds = {data};
+    while (bounds.back() < end) {
+        const char* next = bounds.back() + MESH_LOADER_CHUNK_SIZE;
+        if (next >= end) {
+            bounds.push_back(end);
+            break;
+        }
+        const char* lineEnd = (const char*)memchr(next, '\n', end - next);
+        bounds.push_back(lineEnd ? lineEnd + 1 : end);
+    }
+    
+    size_t chunkCount = bounds.size() - 1;
+    std::vector<ObjChunk> chunks(chunkCount);
+    threadPool.ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            chunks[i].failed = false;
+            ParseObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+        }
+    });
+    
+    size_t positionCount = 0, uvCount = 0, normalCount = 0, cornerCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        if (chunk.failed) return std::nullopt;
+        chunk.positionOffset = positionCount;
+        chunk.uvOffset = uvCount;
+        chunk.normalOffset = normalCount;
+        chunk.cornerOffset = cornerCount;
+        positionCount += chunk.positions.size() / 3;
+        uvCount += chunk.uvs.size() / 2;
+        normalCount += chunk.normals.size() / 3;
+        cornerCount += chunk.corners.size();
+    }
+    if (cornerCount == 0 || positionCount > INT32_MAX || cornerCount > UINT32_MAX) return std::nullopt;
+    
+    // Gather the attributes and resolve every corner to global indices
+    std::vector<float> positions(positionCount * 3), uvs(uvCount * 2), normals(normalCount * 3);
+    std::vector<uint8_t> chunkInvalid(chunkCount, 0), chunkMissingNormals(chunkCount, 0);
+    
+    threadPool.ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionOffset * 3);
+            std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + chunk.uvOffset * 2);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalOffset * 3);
+            std::vector<float>().swap(chunk.positions);
+            std::vector<float>().swap(chunk.uvs);
+            std::vector<float>().swap(chunk.normals);
+            
+            for (ObjCorner& corner : chunk.corners) {
+                if (corner.relative & 1) corner.position += (int32_t)chunk.positionOffset;
+                if (corner.relative & 2) corner.uv += (int32_t)chunk.uvOffset;
+                if (corner.relative & 4) corner.normal += (int32_t)chunk.normalOffset;
+                
+                chunkInvalid[i] |= corner.position < 0 || corner.position >= (int64_t)positionCount ||
+                                   corner.uv < -1 || corner.uv >= (int64_t)uvCount ||
+                                   corner.normal < -1 || corner.normal >= (int64_t)normalCount;
+                chunkMissingNormals[i] |= corner.normal < 0;
+            }
+        }
+    });
+    
+    bool missingNormals = false;
+    for (size_t i = 0; i < chunkCount; i++) {
+        if (chunkInvalid[i]) return std::nullopt;
+        missingNormals |= chunkMissingNormals[i] != 0;
+    }
+    
+    std::vector<glm::vec3> smoothNormals;
+    if (missingNormals) {
+        smoothNormals = ComputeSmoothNormals(positions.data(), 3, positionCount, [&](auto triangle) {
+            for (const ObjChunk& chunk : chunks) {
+                for (size_t c = 0; c < chunk.corners.size(); c += 3) {
+                    triangle(chunk.corners[c].position, chunk.corners[c + 1].position, chunk.corners[c + 2].position);
+                }
+            }
+        });
+    }
+    
+    // Split every chunk's corners by shard. The keys are copied, so each shard later reads its own
+    // buckets sequentially instead of chasing corners through the whole file
+    const size_t shardCount = MESH_LOADER_WELD_SHARDS;
+    threadPool.ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            ObjChunk& chunk = chunks[i];
+            chunk.shards.resize(shardCount);
+            chunk.cornerShard.resize(chunk.corners.size());
+            for (std::vector<ObjWeldKey>& shard : chunk.shards) shard.reserve(chunk.corners.size() / shardCount * 5 / 4);
+            
+            for (size_t c = 0; c < chunk.corners.size(); c++) {
+                const ObjCorner& corner = chunk.corners[c];
+                size_t shard = HashObjCorner(corner.position, corner.uv, corner.normal) % shardCount;
+                chunk.shards[shard].push_back({corner.position, corner.uv, corner.normal});
+                chunk.cornerShard[c] = (uint8_t)shard;
+            }
+            std::vector<ObjCorner>().swap(chunk.corners);
+        }
+    });
+    
+    // Each shard numbers its unique keys with its own open-addressing table. cornerVertex keeps the
+    // shard's corners in chunk order, so the indices can be written back sequentially
+    std::vector<std::vector<ObjWeldKey>> shardVertices(shardCount);
+    std::vector<std::vector<uint32_t>> shardCornerVertex(shardCount);
+    
+    threadPool.ParallelFor(shardCount, 1, [&](size_t begin, size_t end) {
+        for (size_t shard = begin; shard < end; shard++) {
+            size_t count = 0;
+            for (const ObjChunk& chunk : chunks) count += chunk.shards[shard].size();
+            
+            size_t capacity = 16;
+            while (capacity < count * 2) capacity <<= 1;
+            std::vector<int32_t> table(capacity, -1);
+            std::vector<ObjWeldKey>& unique = shardVertices[shard];
+            std::vector<uint32_t>& cornerVertex = shardCornerVertex[shard];
+            cornerVertex.reserve(count);
+            
+            for (const ObjChunk& chunk : chunks) {
+                for (const ObjWeldKey& key : chunk.shards[shard]) {
+                    size_t slot = (HashObjCorner(key.position, key.uv, key.normal) / shardCount) & (capacity - 1);
+                    while (true) {
+                        int32_t vertex = table[slot];
+                        if (vertex < 0) {
+                            table[slot] = (int32_t)unique.size();
+                            cornerVertex.push_back((uint32_t)unique.size());
+                            unique.push_back(key);
+                            break;
+                        }
+                        const ObjWeldKey& other = unique[vertex];
+                        if (other.position == key.position && other.uv == key.uv && other.normal == key.normal) {
+                            cornerVertex.push_back((uint32_t)vertex);
+                            break;
+                        }
+                        slot = (slot + 1) & (capacity - 1);
+                    }
+                }
+            }
+        }
+    });
+    
+    // Where each chunk's corners start in every shard's cornerVertex
+    std::vector<size_t> shardOffsets(shardCount + 1, 0);
+    std::vector<size_t> chunkShardStart(chunkCount * shardCount);
+    for (size_t shard = 0; shard < shardCount; shard++) {
+        shardOffsets[shard + 1] = shardOffsets[shard] + shardVertices[shard].size();
+        size_t start = 0;
+        for (size_t i = 0; i < chunkCount; i++) {
+            chunkShardStart[i * shardCount + shard] = start;
+            start += chunks[i].shards[shard].size();
+        }
+    }
+    
+    Mesh mesh{};
+    mesh.vertices.resize(shardOffsets[shardCount] * MeshLayout::stride);
+    mesh.indices.resize(cornerCount);
+    
+    threadPool.ParallelFor(shardCount, 1, [&](size_t begin, size_t end) {
+        for (size_t shard = begin; shard < end; shard++) {
+            for (size_t local = 0; local < shardVertices[shard].size(); local++) {
+                const ObjWeldKey& key = shardVertices[shard][local];
+                float* vertex = &mesh.vertices[(shardOffsets[shard] + local) * MeshLayout::stride];
+                float* normal = vertex + MeshLayout::Offset<NormalAttribute>();
+                float* uv = vertex + MeshLayout::Offset<UVAttribute>();
+                
+                memcpy(vertex + MeshLayout::Offset<PositionAttribute>(), &positions[key.position * 3], 3 * sizeof(float));
+                if (key.normal >= 0) {
+                    memcpy(normal, &normals[key.normal * 3], 3 * sizeof(float));
+                }
+                else {
+                    glm::vec3 smooth = smoothNormals[key.position];
+                    normal[0] = smooth.x; normal[1] = smooth.y; normal[2] = smooth.z;
+                }
+                uv[0] = key.uv >= 0 ? uvs[key.uv * 2] : 0.0f;
+                uv[1] = key.uv >= 0 ? 1.0f - uvs[key.uv * 2 + 1] : 0.0f;
+            }
+        }
+    });
+    
+    threadPool.ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const ObjChunk& chunk = chunks[i];
+            size_t cursor[MESH_LOADER_WELD_SHARDS];
+            for (size_t shard = 0; shard < shardCount; shard++) cursor[shard] = chunkShardStart[i * shardCount + shard];
+            
+            uint32_t* indices = &mesh.indices[chunk.cornerOffset];
+            for (size_t c = 0; c < chunk.cornerShard.size(); c++) {
+                size_t shard = chunk.cornerShard[c];
+                indices[c] = (uint32_t)shardOffsets[shard] + shardCornerVertex[shard][cursor[shard]++];
+            }
+        }
+    });
+    
+    return mesh;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// PLY //
+// ------------------------------------------------------------------------------------------------------------- //
+
+typedef enum plyType {
+    PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID
+} PlyType;
+
+typedef struct plyProperty {
+    std::string name;
+    PlyType type;
+    PlyType countType;
+    bool list;
+    int offset;
+} PlyProperty;
+
+typedef struct plyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+    int stride;
+} PlyElement;
+
+PlyType GetPlyType(const std::string& name) {
+    
+    if (name == "char" || name == "int8")       return PLY_INT8;
+    if (name == "uchar" || name == "uint8")     return PLY_UINT8;
+    if (name == "short" || name == "int16")     return PLY_INT16;
+    if (name == "ushort" || name == "uint16")   return PLY_UINT16;
+    if (name == "int" || name == "int32")       return PLY_INT32;
+    if (name == "uint" || name == "uint32")     return PLY_UINT32;
+    if (name == "float" || name == "float32")   return PLY_FLOAT32;
+    if (name == "double" || name == "float64")  return PLY_FLOAT64;
+    return PLY_INVALID;
+}
+
+inline int GetPlyTypeSize(PlyType type) {
+    static const int sizes[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+    return sizes[type];
+}
+
+inline double ReadPlyValue(const char* p, PlyType type, bool swap) {
+    
+    char bytes[8];
+    int size = GetPlyTypeSize(type);
+    memcpy(bytes, p, size);
+    if (swap) std::reverse(bytes, bytes + size);
+    
+    switch (type) {
+        case PLY_INT8:      { int8_t v;   memcpy(&v, bytes, 1); return v; }
+        case PLY_UINT8:     { uint8_t v;  memcpy(&v, bytes, 1); return v; }
+        case PLY_INT16:     { int16_t v;  memcpy(&v, bytes, 2); return v; }
+        case PLY_UINT16:    { uint16_t v; memcpy(&v, bytes, 2); return v; }
+        case PLY_INT32:     { int32_t v;  memcpy(&v, bytes, 4); return v; }
+        case PLY_UINT32:    { uint32_t v; memcpy(&v, bytes, 4); return v; }
+        case PLY_FLOAT32:   { float v;    memcpy(&v, bytes, 4); return v; }
+        case PLY_FLOAT64:   { double v;   memcpy(&v, bytes, 8); return v; }
+        default:            return 0.0;
+    }
+}
+
+// Binary PLY (either byte order). Vertices have a fixed stride and are decoded in parallel; faces are
+// variable-length lists and are walked once, with a memcpy fast path for the usual uchar/int triangles.
+// PLY is already indexed, so no welding is needed. ASCII files are left to Assimp.
+std::optional<Mesh> LoadPLY(const char* data, size_t size) {
+    
+    const char* end = data + size;
+    const char* headerEnd = nullptr;
+    for (const char* p = data; p + 10 <= end; p++) {
+        if (memcmp(p, "end_header", 10) == 0 && (p == data || p[-1] == '\n')) {
+            headerEnd = (const char*)memchr(p, '\n', end - p);
+            break;
+        }
+    }
+    if (size < 4 || memcmp(data, "ply", 3) != 0 || !headerEnd) return std::nullopt;
+    
+    std::istringstream header(std::string(data, headerEnd));
+    std::vector<PlyElement> elements;
+    std::string line;
+    bool swap = false, binary = false;
+    
+    while (std::getline(header, line)) {
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        
+        if (keyword == "format") {
+            std::string format;
+            words >> format;
+            binary = format == "binary_little_endian" || format == "binary_big_endian";
+            swap = format == "binary_big_endian";
+        }
+        else if (keyword == "element") {
+            PlyElement element{};
+            words >> element.name >> element.count;
+            elements.push_back(element);
+        }
+        else if (keyword == "property" && !elements.empty()) {
+            PlyProperty property{};
+            std::string type;
+            words >> type;
+            if (type == "list") {
+                std::string countType, valueType;
+                words >> countType >> valueType;
+                property.list = true;
+                property.countType = GetPlyType(countType);
+                property.type = GetPlyType(valueType);
+                if (property.countType == PLY_INVALID) return std::nullopt;
+            }
+            else {
+                property.type = GetPlyType(type);
+            }
+            words >> property.name;
+            if (property.type == PLY_INVALID) return std::nullopt;
+            elements.back().properties.push_back(property);
+        }
+    }
+    if (!binary) return std::nullopt;
+    
+    for (PlyElement& element : elements) {
+        for (PlyProperty& property : element.properties) {
+            if (property.list) {
+                element.stride = -1;
+                break;
+            }
+            property.offset = element.stride;
+            element.stride += GetPlyTypeSize(property.type);
+        }
+    }
+    
+    Mesh mesh{};
+    size_t vertexCount = 0;
+    bool hasNormals = false, hasVertices = false;
+    const char* p = headerEnd + 1;
+    
+    for (const PlyElement& element : elements) {
+        if (element.name == "vertex") {
+            if (element.stride < 0 || (size_t)(end - p) / std::max(element.stride, 1) < element.count) return std::nullopt;
+            
+            const PlyProperty* fields[8] = {};
+            const char* names[8][3] = {
+                {"x", "x", "x"}, {"y", "y", "y"}, {"z", "z", "z"},
+                {"nx", "nx", "nx"}, {"ny", "ny", "ny"}, {"nz", "nz", "nz"},
+                {"u", "s", "texture_u"}, {"v", "t", "texture_v"}
+            };
+            for (const PlyProperty& property : element.properties) {
+                for (int field = 0; field < 8; field++) {
+                    for (const char* name : names[field]) {
+                        if (property.name == name) fields[field] = &property;
+                    }
+                }
+            }
+            if (!fields[0] || !fields[1] || !fields[2]) return std::nullopt;
+            hasNormals = fields[3] && fields[4] && fields[5];
+            
+            vertexCount = element.count;
+            const size_t positionOffset = MeshLayout::Offset<PositionAttribute>();
+            const size_t normalOffset = MeshLayout::Offset<NormalAttribute>();
+            const size_t uvOffset = MeshLayout::Offset<UVAttribute>();
+            const size_t targets[8] = {
+                positionOffset, positionOffset + 1, positionOffset + 2,
+                normalOffset, normalOffset + 1, normalOffset + 2,
+                uvOffset, uvOffset + 1
+            };
+            
+            mesh.vertices.resize(vertexCount * MeshLayout::stride);
+            const char* vertexData = p;
+            
+            threadPool.ParallelFor(vertexCount, 16384, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    const char* source = vertexData + i * element.stride;
+                    float* vertex = &mesh.vertices[i * MeshLayout::stride];
+                    for (int field = 0; field < 8; field++) {
+                        vertex[targets[field]] = fields[field] ? (float)ReadPlyValue(source + fields[field]->offset, fields[field]->type, swap) : 0.0f;
+                    }
+                    if (fields[7]) vertex[uvOffset + 1] = 1.0f - vertex[uvOffset + 1];
+                }
+            });
+            p += element.count * element.stride;
+            hasVertices = true;
+        }
+        else if (element.name == "face") {
+            if (!hasVertices) return std::nullopt;
+            
+            const PlyProperty* indices = nullptr;
+            for (const PlyProperty& property : element.properties) {
+                if (property.list && (property.name == "vertex_indices" || property.name == "vertex_index")) indices = &property;
+            }
+            if (!indices) return std::nullopt;
+            
+            int countSize = GetPlyTypeSize(indices->countType);
+            int indexSize = GetPlyTypeSize(indices->type);
+            bool fastPath = element.properties.size() == 1 && indices->countType == PLY_UINT8 && indexSize == 4 && !swap;
+            mesh.indices.reserve(element.count * 3);
+            
+            uint32_t polygon[256];
+            for (size_t face = 0; face < element.count; face++) {
+                if (fastPath) {
+                    if (end - p < 1) return std::nullopt;
+                    uint32_t count = (uint8_t)*p;
+                    if ((size_t)(end - p - 1) < count * 4) return std::nullopt;
+                    memcpy(polygon, p + 1, count * 4);
+                    p += 1 + count * 4;
+                    
+                    for (uint32_t i = 0; i < count; i++) {
+                        if (polygon[i] >= vertexCount) return std::nullopt;
+                    }
+                    for (uint32_t i = 1; i + 1 < count; i++) {
+                        mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i], polygon[i + 1]});
+                    }
+                    continue;
+                }
+                
+                for (const PlyProperty& property : element.properties) {
+                    if (!property.list) {
+                        if (end - p < GetPlyTypeSize(property.type)) return std::nullopt;
+                        p += GetPlyTypeSize(property.type);
+                        continue;
+                    }
+                    if (end - p < countSize) return std::nullopt;
+                    double listSize = ReadPlyValue(p, property.countType, swap);
+                    p += countSize;
+                    if (listSize < 0 || (size_t)(end - p) < (size_t)listSize * GetPlyTypeSize(property.type)) return std::nullopt;
+                    size_t count = (size_t)listSize;
+                    
+                    if (&property == indices) {
+                        if (count > 256) return std::nullopt;
+                        for (size_t i = 0; i < count; i++) {
+                            double index = ReadPlyValue(p + i * indexSize, property.type, swap);
+                            if (index < 0 || index >= vertexCount) return std::nullopt;
+                            polygon[i] = (uint32_t)index;
+                        }
+                        for (size_t i = 1; i + 1 < count; i++) {
+                            mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i], polygon[i + 1]});
+                        }
+                    }
+                    p += count * GetPlyTypeSize(property.type);
+                }
+            }
+            break;
+        }
+        else if (element.stride >= 0) {
+            if ((size_t)(end - p) / std::max(element.stride, 1) < element.count) return std::nullopt;
+            p += element.count * element.stride;
+        }
+        else {
+            return std::nullopt;
+        }
+    }
+    if (mesh.indices.empty()) return std::nullopt;
+    
+    if (!hasNormals) {
+        std::vector<glm::vec3> normals = ComputeSmoothNormals(mesh.vertices.data() + MeshLayout::Offset<PositionAttribute>(), MeshLayout::stride, vertexCount, [&](auto triangle) {
+            for (size_t c = 0; c < mesh.indices.size(); c += 3) {
+                triangle(mesh.indices[c], mesh.indices[c + 1], mesh.indices[c + 2]);
+            }
+        });
+        for (size_t i = 0; i < vertexCount; i++) {
+            float* normal = &mesh.vertices[i * MeshLayout::stride + MeshLayout::Offset<NormalAttribute>()];
+            normal[0] = normals[i].x;
+            normal[1] = normals[i].y;
+            normal[2] = normals[i].z;
+        }
+    }
+    return mesh;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// LoadMeshFile //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Returns nothing for other formats, or for a file this loader can't read; the caller falls back to Assimp.
+std::optional<Mesh> LoadMeshFile(const std::string& path) {
+    
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return std::nullopt;
+    
+    std::string extension = path.substr(dot + 1);
+    for (char& c : extension) c = (char)std::tolower((unsigned char)c);
+    if (extension != "obj" && extension != "ply") return std::nullopt;
+    
+    MappedFile file;
+    if (!file.Open(path)) return std::nullopt;
+    
+    if (extension == "obj") return LoadOBJ(file.Data(), file.Size());
+    return LoadPLY(file.Data(), file.Size());
+}
+
+// Little-endian binary PLY with everything LoadPLY reads back: positions, normals, uvs and triangles.
+bool SaveBinaryPLY(const std::string& path, const Mesh& mesh) {
+    
+    size_t vertexCount = MeshLayout::Count(mesh.vertices);
+    size_t triangleCount = mesh.indices.size() / 3;
+    
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output) return false;
+    output << "ply\nformat binary_little_endian 1.0\n"
+           << "element vertex " << vertexCount << "\n"
+           << "property float x\nproperty float y\nproperty float z\n"
+           << "property float nx\nproperty float ny\nproperty float nz\n"
+           << "property float s\nproperty float t\n"
+           << "element face " << triangleCount << "\n"
+           << "property list uchar uint vertex_indices\nend_header\n";
+    
+    const size_t uvOffset = MeshLayout::Offset<UVAttribute>();
+    std::vector<float> vertices = mesh.vertices;
+    for (size_t i = 0; i < vertexCount; i++) {
+        vertices[i * MeshLayout::stride + uvOffset + 1] = 1.0f - vertices[i * MeshLayout::stride + uvOffset + 1];
+    }
+    output.write((const char*)vertices.data(), (std::streamsize)(vertexCount * MeshLayout::stride * sizeof(float)));
+    
+    std::vector<char> faces(triangleCount * 13);
+    for (size_t i = 0; i < triangleCount; i++) {
+        faces[i * 13] = 3;
+        memcpy(&faces[i * 13 + 1], &mesh.indices[i * 3], 3 * sizeof(uint32_t));
+    }
+    output.write(faces.data(), (std::streamsize)faces.size());
+    return (bool)output;
+}
+
+#endif /* mesh_loader_h */
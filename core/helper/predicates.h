@@ -0,0 +1,234 @@
+//
+//  predicates.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef predicates_h
+#define predicates_h
+
+#include <cfloat>
+#include <cmath>
+
+// Orientation tests that always get the sign right. The determinant is first evaluated in double, which
+// holds float input with room to spare, and trusted whenever it clears Shewchuk's error bound; only the
+// nearly degenerate cases that don't are redone in exact expansion arithmetic.
+
+// Relative error bound of a 3x3 determinant of rounded differences, against its permanent
+#define PREDICATE_DETERMINANT_ERROR ((7.0 + 56.0 * DBL_EPSILON / 2.0) * DBL_EPSILON / 2.0)
+// Terms an exact 3x3 determinant of two-term rows can expand to
+#define PREDICATE_EXPANSION_LENGTH 192
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Expansion arithmetic //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// An expansion holds a value exactly as a sum of doubles that don't overlap, smallest first, so its sign is
+// the sign of its last term. Zero terms are dropped as they appear.
+
+inline void TwoSum(double a, double b, double& sum, double& error) {
+    
+    sum = a + b;
+    double virtualB = sum - a;
+    double virtualA = sum - virtualB;
+    error = (a - virtualA) + (b - virtualB);
+}
+
+inline void TwoDifference(double a, double b, double& difference, double& error) {
+    
+    difference = a - b;
+    double virtualB = a - difference;
+    double virtualA = difference + virtualB;
+    error = (a - virtualA) + (virtualB - b);
+}
+
+inline void TwoProduct(double a, double b, double& product, double& error) {
+    product = a * b;
+    error = std::fma(a, b, -product);
+}
+
+// e += b in place; e needs room for one more term.
+int GrowExpansion(double* e, int length, double b) {
+    
+    double sum = b;
+    int out = 0;
+    for (int i = 0; i < length; i++) {
+        double error;
+        TwoSum(sum, e[i], sum, error);
+        if (error != 0.0) e[out++] = error;
+    }
+    if (sum != 0.0 || out == 0) e[out++] = sum;
+    return out;
+}
+
+// e += f in place; e needs room for length + fLength terms.
+int AddExpansions(double* e, int length, const double* f, int fLength) {
+    
+    for (int i = 0; i < fLength; i++) {
+        length = GrowExpansion(e, length, f[i]);
+    }
+    return length;
+}
+
+// h = e * b, with room for 2 * length terms.
+int ScaleExpansion(const double* e, int length, double b, double* h) {
+    
+    double sum, error, product, productError;
+    TwoProduct(e[0], b, sum, error);
+    int out = 0;
+    if (error != 0.0) h[out++] = error;
+    
+    for (int i = 1; i < length; i++) {
+        TwoProduct(e[i], b, product, productError);
+        TwoSum(sum, productError, sum, error);
+        if (error != 0.0) h[out++] = error;
+        TwoSum(product, sum, sum, error);
+        if (error != 0.0) h[out++] = error;
+    }
+    if (sum != 0.0 || out == 0) h[out++] = sum;
+    return out;
+}
+
+// h = e * f, with room for 2 * length * fLength terms. e has at most 32 terms.
+int MultiplyExpansions(const double* e, int length, const double* f, int fLength, double* h) {
+    
+    double scaled[64];
+    int out = 0;
+    for (int i = 0; i < fLength; i++) {
+        int scaledLength = ScaleExpansion(e, length, f[i], scaled);
+        out = AddExpansions(h, out, scaled, scaledLength);
+    }
+    return out;
+}
+
+// det[row 0; row 1; row 2] exactly, each entry a two-term expansion. Returns the leading term, which carries
+// the sign.
+double ExactDeterminant3(const double rows[3][3][2]) {
+    
+    double total[PREDICATE_EXPANSION_LENGTH];
+    int totalLength = 0;
+    
+    for (int axis = 0; axis < 3; axis++) {
+        int i = (axis + 1) % 3, j = (axis + 2) % 3;
+        
+        // rows[1][i] * rows[2][j] - rows[1][j] * rows[2][i]
+        double minor[16], negative[8];
+        int minorLength = MultiplyExpansions(rows[1][i], 2, rows[2][j], 2, minor);
+        int negativeLength = MultiplyExpansions(rows[1][j], 2, rows[2][i], 2, negative);
+        for (int k = 0; k < negativeLength; k++) negative[k] = -negative[k];
+        minorLength = AddExpansions(minor, minorLength, negative, negativeLength);
+        
+        double term[64];
+        int termLength = MultiplyExpansions(minor, minorLength, rows[0][axis], 2, term);
+        totalLength = AddExpansions(total, totalLength, term, termLength);
+    }
+    return total[totalLength - 1];
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Predicates //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// The minors of det[x; u; v] along its first row, and the matching terms of the permanent that bounds the
+// rounding error of the determinant.
+inline void ComputeMinors(const double u[3], const double v[3], double minor[3], double magnitude[3]) {
+    
+    double firstX = u[1] * v[2], secondX = u[2] * v[1];
+    double firstY = u[2] * v[0], secondY = u[0] * v[2];
+    double firstZ = u[0] * v[1], secondZ = u[1] * v[0];
+    minor[0] = firstX - secondX;
+    minor[1] = firstY - secondY;
+    minor[2] = firstZ - secondZ;
+    magnitude[0] = std::abs(firstX) + std::abs(secondX);
+    magnitude[1] = std::abs(firstY) + std::abs(secondY);
+    magnitude[2] = std::abs(firstZ) + std::abs(secondZ);
+}
+
+// det[x; u; v] from the minors of u and v, trusted when it clears the error bound. Returns false when only
+// exact arithmetic can tell its sign.
+inline bool FilterDeterminant3(const double x[3], const double minor[3], const double magnitude[3], double& determinant) {
+    
+    determinant = x[0] * minor[0] + x[1] * minor[1] + x[2] * minor[2];
+    double permanent = std::abs(x[0]) * magnitude[0] + std::abs(x[1]) * magnitude[1] + std::abs(x[2]) * magnitude[2];
+    return std::abs(determinant) > PREDICATE_DETERMINANT_ERROR * permanent;
+}
+
+// det[p[0] - q[0]; p[1] - q[1]; p[2] - q[2]] in exact arithmetic, for the few cases the filter can't
+// decide. Returns the leading term, which carries the sign.
+double ExactDifferenceDeterminant3(const glm::vec3 p[3], const glm::vec3 q[3]) {
+    
+    double rows[3][3][2];
+    for (int row = 0; row < 3; row++) {
+        for (int axis = 0; axis < 3; axis++) TwoDifference(p[row][axis], q[row][axis], rows[row][axis][1], rows[row][axis][0]);
+    }
+    return ExactDeterminant3(rows);
+}
+
+// Plane abc with the minors of b - a and c - a worked out once, so testing many points against one face
+// costs a dot product each.
+typedef struct orientPlane {
+    glm::vec3 a, b, c;
+    double minor[3];
+    double magnitude[3];
+} OrientPlane;
+
+OrientPlane CreateOrientPlane(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    
+    OrientPlane plane;
+    plane.a = a;
+    plane.b = b;
+    plane.c = c;
+    
+    double u[3], v[3];
+    for (int axis = 0; axis < 3; axis++) {
+        u[axis] = (double)b[axis] - (double)a[axis];
+        v[axis] = (double)c[axis] - (double)a[axis];
+    }
+    ComputeMinors(u, v, plane.minor, plane.magnitude);
+    return plane;
+}
+
+// Positive when d lies on the side of plane abc that cross(b - a, c - a) points to, negative on the other
+// side and exactly zero when the four points are coplanar. The value is the determinant when the filter
+// is certain, otherwise the leading term of the exact one, so only its sign should be relied on.
+inline double Orient3D(const OrientPlane& plane, const glm::vec3& d) {
+    
+    const double offset[3] = {(double)d.x - plane.a.x, (double)d.y - plane.a.y, (double)d.z - plane.a.z};
+    double determinant;
+    if (FilterDeterminant3(offset, plane.minor, plane.magnitude, determinant)) return determinant;
+    
+    // Hulls sharing vertices test them against their own faces all the time
+    if (d == plane.a || d == plane.b || d == plane.c) return 0.0;
+    
+    const glm::vec3 p[3] = {d, plane.b, plane.c};
+    const glm::vec3 q[3] = {plane.a, plane.a, plane.a};
+    return ExactDifferenceDeterminant3(p, q);
+}
+
+inline double Orient3D(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    return Orient3D(CreateOrientPlane(a, b, c), d);
+}
+
+// Which way the ray turns around the directed line from a to b: positive when a, b seen from the origin
+// wind counter-clockwise around the direction, zero when the ray meets the line. Two triangles sharing an
+// edge get exactly opposite signs for it, so no ray slips between them. offsetA and offsetB are a and b
+// less the origin in double, which the three edges of a triangle share.
+inline double OrientRay(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b,
+                        const double offsetA[3], const double offsetB[3]) {
+    
+    const double row[3] = {direction.x, direction.y, direction.z};
+    double minor[3], magnitude[3], determinant;
+    ComputeMinors(offsetA, offsetB, minor, magnitude);
+    if (FilterDeterminant3(row, minor, magnitude, determinant)) return determinant;
+    
+    const glm::vec3 p[3] = {direction, a, b};
+    const glm::vec3 q[3] = {glm::vec3(0.0f), origin, origin};
+    return ExactDifferenceDeterminant3(p, q);
+}
+
+#endif /* predicates_h */
@@ -22,79 +22,86 @@ struct Intersection {
     float distance;
 };
 
+// The ray hits when it passes every edge the same way round and the triangle's plane lies strictly ahead
+// of its origin. Both are decided exactly, so a ray through a shared edge or vertex always hits one of
+// the triangles around it and a ray grazing the plane never reports a hit behind its origin.
 std::optional<Intersection> RayIntersectTriangle(const Ray& ray, const glm::vec3& pointA, const glm::vec3& pointB, const glm::vec3& pointC) {
     
-    glm::vec3 edge1 = pointB - pointA;
-    glm::vec3 edge2 = pointC - pointA;
-    glm::vec3 h = glm::cross(ray.direction, edge2);
-    float a = glm::dot(edge1, h);
+    double offsetA[3], offsetB[3], offsetC[3];
+    for (int axis = 0; axis < 3; axis++) {
+        offsetA[axis] = (double)pointA[axis] - (double)ray.origin[axis];
+        offsetB[axis] = (double)pointB[axis] - (double)ray.origin[axis];
+        offsetC[axis] = (double)pointC[axis] - (double)ray.origin[axis];
+    }
     
-    if (fabs(a) < 0.0000001f) return std::nullopt;
-    float f = 1.0f / a;
+    double sideA = OrientRay(ray.origin, ray.direction, pointB, pointC, offsetB, offsetC);
+    double sideB = OrientRay(ray.origin, ray.direction, pointC, pointA, offsetC, offsetA);
+    if ((sideA < 0.0 && sideB > 0.0) || (sideA > 0.0 && sideB < 0.0)) return std::nullopt;
     
-    glm::vec3 s = ray.origin - pointA;
-    float u = f * glm::dot(s, h);
-    if (u < 0.0f || u > 1.0f) return std::nullopt;
+    double sideC = OrientRay(ray.origin, ray.direction, pointA, pointB, offsetA, offsetB);
+    if ((sideC < 0.0 && (sideA > 0.0 || sideB > 0.0)) || (sideC > 0.0 && (sideA < 0.0 || sideB < 0.0))) return std::nullopt;
     
-    glm::vec3 q = glm::cross(s, edge1);
-    float v = f * glm::dot(ray.direction, q);
-    if (v < 0.0f || u + v > 1.0f) return std::nullopt;
+    // The sides add up to dot(direction, normal), which is zero for a ray parallel to the triangle
+    double facing = sideA + sideB + sideC;
+    if (facing == 0.0) return std::nullopt;
     
-    float t = f * glm::dot(edge2, q);
-    if (t > 0.0000001f) {
-        return Intersection{ray.origin + ray.direction * t, glm::vec3(0.0f), t};
-    }
+    double height = Orient3D(pointA, pointB, pointC, ray.origin);
+    if (height == 0.0 || (height > 0.0) == (facing > 0.0)) return std::nullopt;
     
-    return std::nullopt;
+    float t = (float)(-height / facing);
+    return Intersection{ray.origin + ray.direction * t, glm::vec3(0.0f), t};
 }
 
-std::optional<Intersection> Raycast(const Ray& ray, const std::vector<float>& vertices, const std::vector<uint32_t>& indices) {
+// Closest hit against an indexed triangle list over a packed position stream. Triangle soups are
+// welded into indexed meshes on the way in, so there is no separate non-indexed path.
+std::optional<Intersection> Raycast(const Ray& ray, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
     
     std::optional<Intersection> closest;
     
-    if (indices.size() != 0) {
-        for (size_t i = 0; i < indices.size(); i += 3) {
-            glm::vec3 pointA = glm::vec3(vertices[indices[i] * 3], vertices[indices[i] * 3 + 1], vertices[indices[i] * 3 + 2]);
-            glm::vec3 pointB = glm::vec3(vertices[indices[i + 1] * 3], vertices[indices[i + 1] * 3 + 1], vertices[indices[i + 1] * 3 + 2]);
-            glm::vec3 pointC = glm::vec3(vertices[indices[i + 2] * 3], vertices[indices[i + 2] * 3 + 1], vertices[indices[i + 2] * 3 + 2]);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3& pointA = positions[indices[i]];
+        const glm::vec3& pointB = positions[indices[i + 1]];
+        const glm::vec3& pointC = positions[indices[i + 2]];
             
-            auto intersection = RayIntersectTriangle(ray, pointA, pointB, pointC);
-            if (intersection) {
-                if (!closest || intersection->distance < closest->distance) {
-                    closest = intersection;
-                    closest->normal = glm::normalize(glm::cross(pointB - pointA, pointC - pointA));
-                }
+        auto intersection = RayIntersectTriangle(ray, pointA, pointB, pointC);
+        if (intersection) {
+            if (!closest || intersection->distance < closest->distance) {
+                closest = intersection;
+                closest->normal = glm::normalize(glm::cross(pointB - pointA, pointC - pointA));
             }
         }
     }
-    else {
-        for (int i = 0; i < vertices.size()/18; i++) {
-            
-            glm::vec3 pointA = glm::vec3(vertices[i * 18], vertices[i * 18 + 1], vertices[i * 18 + 2]);
-            glm::vec3 pointB = glm::vec3(vertices[i * 18 + 3], vertices[i * 18 + 4], vertices[i * 18 + 5]);
-            glm::vec3 pointC = glm::vec3(vertices[i * 18 + 6], vertices[i * 18 + 7], vertices[i * 18 + 8]);
-            
-            auto intersection = RayIntersectTriangle(ray, pointA, pointB, pointC);
-            if (intersection) {
-                if (!closest || intersection->distance < closest->distance) {
-                    closest = intersection;
-                    closest->normal = glm::normalize(glm::cross(pointB - pointA, pointC - pointA));
-                }
-            }
-            
-            glm::vec3 pointA2 = glm::vec3(vertices[i * 18 + 9], vertices[i * 18 + 10], vertices[i * 18 + 11]);
-            glm::vec3 pointB2 = glm::vec3(vertices[i * 18 + 12], vertices[i * 18 + 13], vertices[i * 18 + 14]);
-            glm::vec3 pointC2 = glm::vec3(vertices[i * 18 + 15], vertices[i * 18 + 16], vertices[i * 18 + 17]);
-            
-            intersection = RayIntersectTriangle(ray, pointA2, pointB2, pointC2);
-            if (intersection) {
-                if (!closest || intersection->distance < closest->distance) {
-                    closest = intersection;
-                    closest->normal = glm::normalize(glm::cross(pointB2 - pointA2, pointC2 - pointA2));
-                }
-            }
+    return closest;
+}
+
+// Same, against interleaved vertices placed in the world by transform. The ray is taken into the mesh's
+// local space instead of transforming every vertex; an affine map keeps the ray parameter, so the
+// distance needs no conversion.
+template<typename Layout>
+std::optional<Intersection> RaycastVertices(const Ray& ray, const std::vector<float>& vertices, const std::vector<uint32_t>& indices, const glm::mat4& transform) {
+    
+    glm::mat4 inverse = glm::inverse(transform);
+    Ray local{glm::vec3(inverse * glm::vec4(ray.origin, 1.0f)), glm::mat3(inverse) * ray.direction};
+    
+    std::optional<Intersection> closest;
+    glm::vec3 localNormal;
+    
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        glm::vec3 pointA = Layout::Position(vertices.data(), indices[i]);
+        glm::vec3 pointB = Layout::Position(vertices.data(), indices[i + 1]);
+        glm::vec3 pointC = Layout::Position(vertices.data(), indices[i + 2]);
+        
+        auto intersection = RayIntersectTriangle(local, pointA, pointB, pointC);
+        if (intersection && (!closest || intersection->distance < closest->distance)) {
+            closest = intersection;
+            localNormal = glm::cross(pointB - pointA, pointC - pointA);
         }
     }
+    
+    if (closest) {
+        closest->intersectionPoint = ray.origin + ray.direction * closest->distance;
+        closest->normal = glm::normalize(glm::transpose(glm::mat3(inverse)) * localNormal);
+    }
     return closest;
 }
 
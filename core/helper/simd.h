@@ -0,0 +1,118 @@
+//
+//  simd.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-18.
+//
+
+#ifndef simd_h
+#define simd_h
+
+// 4-wide float vectors over SSE on x86 and NEON on Apple silicon, with a plain
+// scalar fallback so the hot loops compile everywhere.
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+
+typedef __m128 float4;
+
+inline float4 Float4Load(const float* p)                  { return _mm_loadu_ps(p); }
+inline float4 Float4Set(float v)                          { return _mm_set1_ps(v); }
+inline void   Float4Store(float* p, float4 a)             { _mm_storeu_ps(p, a); }
+inline float4 Float4Add(float4 a, float4 b)               { return _mm_add_ps(a, b); }
+inline float4 Float4Sub(float4 a, float4 b)               { return _mm_sub_ps(a, b); }
+inline float4 Float4Mul(float4 a, float4 b)               { return _mm_mul_ps(a, b); }
+inline float4 Float4Div(float4 a, float4 b)               { return _mm_div_ps(a, b); }
+inline float4 Float4Min(float4 a, float4 b)               { return _mm_min_ps(a, b); }
+inline float4 Float4Max(float4 a, float4 b)               { return _mm_max_ps(a, b); }
+inline float4 Float4Greater(float4 a, float4 b)           { return _mm_cmpgt_ps(a, b); }
+inline float4 Float4Select(float4 mask, float4 a, float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline int    Float4MoveMask(float4 mask)                 { return _mm_movemask_ps(mask); }
+
+inline float Float4HorizontalMin(float4 a) {
+    a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(a);
+}
+
+inline float Float4HorizontalMax(float4 a) {
+    a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(a);
+}
+
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+
+typedef float32x4_t float4;
+
+inline float4 Float4Load(const float* p)                  { return vld1q_f32(p); }
+inline float4 Float4Set(float v)                          { return vdupq_n_f32(v); }
+inline void   Float4Store(float* p, float4 a)             { vst1q_f32(p, a); }
+inline float4 Float4Add(float4 a, float4 b)               { return vaddq_f32(a, b); }
+inline float4 Float4Sub(float4 a, float4 b)               { return vsubq_f32(a, b); }
+inline float4 Float4Mul(float4 a, float4 b)               { return vmulq_f32(a, b); }
+inline float4 Float4Div(float4 a, float4 b)               { return vdivq_f32(a, b); }
+inline float4 Float4Min(float4 a, float4 b)               { return vminq_f32(a, b); }
+inline float4 Float4Max(float4 a, float4 b)               { return vmaxq_f32(a, b); }
+inline float4 Float4Greater(float4 a, float4 b)           { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+inline float4 Float4Select(float4 mask, float4 a, float4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+inline float  Float4HorizontalMin(float4 a)               { return vminvq_f32(a); }
+inline float  Float4HorizontalMax(float4 a)               { return vmaxvq_f32(a); }
+
+inline int Float4MoveMask(float4 mask) {
+    uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+    return (int)(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) | (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+}
+
+#else
+#include <cstring>
+
+typedef struct float4 {
+    float v[4];
+} float4;
+
+inline float4 Float4Load(const float* p)                  { return float4{{p[0], p[1], p[2], p[3]}}; }
+inline float4 Float4Set(float v)                          { return float4{{v, v, v, v}}; }
+inline void   Float4Store(float* p, float4 a)             { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+inline float4 Float4Add(float4 a, float4 b)               { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+inline float4 Float4Sub(float4 a, float4 b)               { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+inline float4 Float4Mul(float4 a, float4 b)               { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+inline float4 Float4Div(float4 a, float4 b)               { for (int i = 0; i < 4; i++) a.v[i] /= b.v[i]; return a; }
+inline float4 Float4Min(float4 a, float4 b)               { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+inline float4 Float4Max(float4 a, float4 b)               { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+
+inline float4 Float4Greater(float4 a, float4 b) {
+    float4 mask;
+    for (int i = 0; i < 4; i++) {
+        uint32_t bits = a.v[i] > b.v[i] ? 0xFFFFFFFFu : 0u;
+        std::memcpy(&mask.v[i], &bits, sizeof(float));
+    }
+    return mask;
+}
+
+inline float4 Float4Select(float4 mask, float4 a, float4 b) {
+    for (int i = 0; i < 4; i++) {
+        uint32_t bits;
+        std::memcpy(&bits, &mask.v[i], sizeof(float));
+        a.v[i] = bits ? a.v[i] : b.v[i];
+    }
+    return a;
+}
+
+inline int Float4MoveMask(float4 mask) {
+    int result = 0;
+    for (int i = 0; i < 4; i++) {
+        uint32_t bits;
+        std::memcpy(&bits, &mask.v[i], sizeof(float));
+        result |= (bits >> 31) << i;
+    }
+    return result;
+}
+
+inline float Float4HorizontalMin(float4 a) { return std::min(std::min(a.v[0], a.v[1]), std::min(a.v[2], a.v[3])); }
+inline float Float4HorizontalMax(float4 a) { return std::max(std::max(a.v[0], a.v[1]), std::max(a.v[2], a.v[3])); }
+
+#endif
+
+#endif /* simd_h */
@@ -10,13 +10,18 @@
 
 #include <queue>
 #include <thread>
+#include <atomic>
+#include <memory>
 #include <functional>
+#include <exception>
 #include <condition_variable>
 
 class ThreadPool {
 public:
     ThreadPool(size_t numThreads);
     void Enqueue(std::function<void()> task);
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body);
+    size_t Size() const;
     ~ThreadPool();
     
 private:
@@ -41,29 +46,93 @@ void ThreadPool::Enqueue(std::function<void()> task) {
     condition.notify_one();
 }
 
+// Splits [0, count) into chunks of grainSize and runs them on the pool. The calling thread
+// takes chunks as well, so ParallelFor can be nested inside a pool task without deadlocking.
+// Chunks allocate under the caller's memory stage. The first exception thrown by a chunk is rethrown
+// on the calling thread once every chunk has finished.
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body) {
+    
+    if (count == 0) return;
+    grainSize = std::max<size_t>(grainSize, 1);
+    
+    size_t chunks = (count + grainSize - 1) / grainSize;
+    if (chunks == 1 || workers.empty()) {
+        body(0, count);
+        return;
+    }
+    
+    struct ParallelState {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    std::shared_ptr<ParallelState> state = std::make_shared<ParallelState>();
+    
+    auto run = [state, count, grainSize, chunks, &body, stage = currentMemoryStage]() {
+        MemoryStageScope scope(stage);
+        size_t chunk;
+        while ((chunk = state->next.fetch_add(1)) < chunks) {
+            size_t begin = chunk * grainSize;
+            try {
+                body(begin, std::min(begin + grainSize, count));
+            }
+            catch (...) {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+            
+            if (state->done.fetch_add(1) + 1 == chunks) {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+    
+    size_t helpers = std::min(workers.size(), chunks - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        Enqueue(run);
+    }
+    run();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state, chunks] { return state->done.load() == chunks; });
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+size_t ThreadPool::Size() const {
+    return workers.size();
+}
+
 void ThreadPool::Worker() {
     
     while (true) {
         std::function<void()> task;
-        std::unique_lock<std::mutex> lock(queueMutex);
-        condition.wait(lock, [this] { return stop || !tasks.empty(); });
-        
-        if (stop && tasks.empty()) return;
-        
-        task = std::move(tasks.front());
-        tasks.pop();
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            condition.wait(lock, [this] { return stop || !tasks.empty(); });
+            
+            if (stop && tasks.empty()) return;
+            
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
         task();
     }
 }
 
 ThreadPool::~ThreadPool() {
-    std::unique_lock<std::mutex> lock(queueMutex);
-    stop = true;
-    condition.notify_all();
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        stop = true;
+        condition.notify_all();
+    }
     for (std::thread& worker : workers) {
         worker.join();
     }
 }
 
+ThreadPool threadPool(std::max(1u, std::thread::hardware_concurrency()));
 
 #endif /* thread_pool_h */
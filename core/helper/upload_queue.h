@@ -0,0 +1,54 @@
+//
+//  upload_queue.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-22.
+//
+
+#ifndef upload_queue_h
+#define upload_queue_h
+
+#include <chrono>
+#include <mutex>
+
+// GL work posted from loader threads and run on the thread that owns the context. Drain is called once
+// per frame and stops after budgetMilliseconds so a burst of finished assets can't stall a frame.
+class UploadQueue {
+public:
+    void Post(std::function<void()> upload);
+    size_t Drain(double budgetMilliseconds);
+    
+private:
+    std::queue<std::function<void()>> uploads;
+    std::mutex mutex;
+};
+
+void UploadQueue::Post(std::function<void()> upload) {
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    uploads.push(std::move(upload));
+}
+
+size_t UploadQueue::Drain(double budgetMilliseconds = 4.0) {
+    
+    auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    while (true) {
+        std::function<void()> upload;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (uploads.empty()) break;
+            upload = std::move(uploads.front());
+            uploads.pop();
+        }
+        upload();
+        count++;
+        
+        if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() > budgetMilliseconds) break;
+    }
+    return count;
+}
+
+UploadQueue uploadQueue;
+
+#endif /* upload_queue_h */
@@ -0,0 +1,85 @@
+//
+//  vertex_layout.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-23.
+//
+
+#ifndef vertex_layout_h
+#define vertex_layout_h
+
+#include <type_traits>
+
+// One float attribute of an interleaved vertex: its component count and shader location.
+template<size_t Components, GLuint Location>
+struct VertexAttribute {
+    static constexpr size_t components = Components;
+    static constexpr GLuint location = Location;
+};
+
+typedef VertexAttribute<3, 0> PositionAttribute;
+typedef VertexAttribute<3, 1> NormalAttribute;
+typedef VertexAttribute<2, 2> UVAttribute;
+
+// Interleaved float vertices holding Attributes in order. Stride and offsets are compile-time constants,
+// so every loop over a layout indexes with constant strides, and the GL attribute setup is generated
+// from the same description the CPU code reads with.
+template<typename... Attributes>
+struct VertexLayout {
+    static constexpr size_t stride = (Attributes::components + ...);
+    
+    template<typename Attribute>
+    static constexpr bool Has() { return (std::is_same_v<Attribute, Attributes> || ...); }
+    
+    template<typename Attribute>
+    static constexpr size_t Offset() {
+        static_assert(Has<Attribute>(), "attribute is not part of this vertex layout");
+        return OffsetOf<Attribute, Attributes...>();
+    }
+    
+    static size_t Count(const std::vector<float>& vertices) { return vertices.size() / stride; }
+    
+    static glm::vec3 Position(const float* vertices, size_t index) {
+        const float* p = vertices + index * stride + Offset<PositionAttribute>();
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+    
+    // Describes the layout to the currently bound vertex array and array buffer.
+    static void EnableAttributes() {
+        (EnableAttribute<Attributes>(), ...);
+    }
+    
+private:
+    template<typename Attribute, typename First, typename... Rest>
+    static constexpr size_t OffsetOf() {
+        if constexpr (std::is_same_v<Attribute, First>) return 0;
+        else return First::components + OffsetOf<Attribute, Rest...>();
+    }
+    
+    template<typename Attribute>
+    static void EnableAttribute() {
+        glVertexAttribPointer(Attribute::location, (GLint)Attribute::components, GL_FLOAT, GL_FALSE, (GLsizei)(stride * sizeof(float)), (void*)(Offset<Attribute>() * sizeof(float)));
+        glEnableVertexAttribArray(Attribute::location);
+    }
+};
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Position streams //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// The positions alone, tightly packed, for the algorithms that never look at the other attributes.
+template<typename Layout>
+std::vector<glm::vec3> ExtractPositions(const std::vector<float>& vertices) {
+    
+    size_t count = Layout::Count(vertices);
+    std::vector<glm::vec3> positions(count);
+    const float* source = vertices.data() + Layout::template Offset<PositionAttribute>();
+    for (size_t i = 0; i < count; i++) {
+        positions[i] = glm::vec3(source[i * Layout::stride], source[i * Layout::stride + 1], source[i * Layout::stride + 2]);
+    }
+    return positions;
+}
+
+#endif /* vertex_layout_h */
@@ -0,0 +1,77 @@
+//
+//  asset_registry.h
+//  VACD
+//
+//  Created by Dmitri Wamback on 2025-03-22.
+//
+
+#ifndef asset_registry_h
+#define asset_registry_h
+
+typedef std::shared_future<std::shared_ptr<const RObject>> AssetFuture;
+
+// Loaded assets by path. Each asset is a prototype RObject holding the geometry, hulls and GL buffers;
+// instances share it through RObject::prototype and only carry a transform. The registry holds weak
+// references, so an asset is released together with its last instance.
+class AssetRegistry {
+public:
+    std::shared_ptr<const RObject> Find(const std::string& path);
+    void Register(const std::string& path, std::shared_ptr<RObject> prototype);
+    void Update();
+    size_t Size() const { return prototypes.size(); }
+    
+    // Loads in flight, so a second request for the same path waits on the first. GL thread only.
+    AssetFuture FindPending(const std::string& path) const;
+    void AddPending(const std::string& path, AssetFuture future);
+    void ClearPending(const std::string& path);
+    
+private:
+    std::unordered_map<std::string, std::weak_ptr<RObject>> prototypes;
+    std::unordered_map<std::string, AssetFuture> pending;
+};
+
+std::shared_ptr<const RObject> AssetRegistry::Find(const std::string& path) {
+    
+    auto entry = prototypes.find(path);
+    if (entry == prototypes.end()) return nullptr;
+    
+    std::shared_ptr<RObject> prototype = entry->second.lock();
+    if (!prototype) prototypes.erase(entry);
+    return prototype;
+}
+
+void AssetRegistry::Register(const std::string& path, std::shared_ptr<RObject> prototype) {
+    prototypes[path] = prototype;
+    pending.erase(path);
+}
+
+AssetFuture AssetRegistry::FindPending(const std::string& path) const {
+    auto entry = pending.find(path);
+    return entry == pending.end() ? AssetFuture() : entry->second;
+}
+
+void AssetRegistry::AddPending(const std::string& path, AssetFuture future) {
+    pending[path] = future;
+}
+
+void AssetRegistry::ClearPending(const std::string& path) {
+    pending.erase(path);
+}
+
+// Once per frame on the render thread: swaps in refined decompositions and forgets released assets.
+void AssetRegistry::Update() {
+    
+    for (auto entry = prototypes.begin(); entry != prototypes.end();) {
+        std::shared_ptr<RObject> prototype = entry->second.lock();
+        if (!prototype) {
+            entry = prototypes.erase(entry);
+            continue;
+        }
+        prototype->ApplyDecompositionSnapshot();
+        entry++;
+    }
+}
+
+AssetRegistry assetRegistry;
+
+#endif /* asset_registry_h */
@@ -8,28 +8,37 @@
 #ifndef model_h
 #define model_h
 
+#define ACD_SIMPLIFY_TARGET_TRIANGLES 200000
+#define ACD_PROGRESSIVE_BUDGET_MS 50.0
+
 class Model: public RObject {
 public:
-    static RObject* Create(std::string assetPath);
+    static RObject* Create(std::string assetPath, std::function<void(float progress)> onProgress);
+    static AssetFuture LoadAsync(std::string assetPath, std::function<void(float progress)> onProgress);
+    static RObject* Instantiate(std::shared_ptr<const RObject> prototype);
+    static std::shared_ptr<Model> ImportFile(const std::string& file);
     void Render(Shader shader) override;
 private:
+    static std::shared_ptr<RObject> Load(std::string assetPath, std::function<void(float progress)> onProgress);
     void ProcessNode(aiNode *node, const aiScene *scene);
     void ProcessMesh(aiMesh *mesh, const aiScene *scene);
+    
+    std::vector<uint8_t> visiblePieces;
 };
 
-RObject* Model::Create(std::string assetPath) {
-    RObject* model = new Model();
+// Instances share the imported and decomposed asset; only the first Create for a path does the work, and
+// only its onProgress hears about the decomposition.
+RObject* Model::Create(std::string assetPath, std::function<void(float progress)> onProgress = nullptr) {
     
-    Assimp::Importer importer;
-    const aiScene *scene = importer.ReadFile("/Users/dmitriwamback/Documents/models/blendermonkey.obj",
-                                             aiProcess_Triangulate |
-                                             aiProcess_FlipUVs |
-                                             aiProcess_JoinIdenticalVertices |
-                                             aiProcess_GenSmoothNormals | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph);
+    std::shared_ptr<const RObject> prototype = assetRegistry.Find(assetPath);
+    if (!prototype) prototype = Load(assetPath, onProgress);
+    return Instantiate(prototype);
+}
+
+RObject* Model::Instantiate(std::shared_ptr<const RObject> prototype) {
     
-    aiNode* rootNode = scene->mRootNode;
-    static_cast<Model*>(model)->ProcessNode(rootNode, scene);
-    static_cast<Model*>(model)->Decompose(1000);
+    RObject* model = new Model();
+    model->prototype = prototype;
     model->scale    = glm::vec3(2.0f, 2.0f, 2.0f);
     model->rotation = glm::vec3(0.0f, 0.0f, 0.0f);
     model->position = glm::vec3(0.0f);
@@ -37,6 +46,108 @@ RObject* Model::Create(std::string assetPath) {
     return model;
 }
 
+// File I/O, parsing and simplification. No GL calls, so it runs on any thread. OBJ and binary PLY go
+// through the native loader; Assimp handles everything else.
+std::shared_ptr<Model> Model::ImportFile(const std::string& file) {
+    MemoryStageScope memoryStage(MEMORY_STAGE_IMPORT);
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    
+    if (std::optional<Mesh> mesh = LoadMeshFile(file)) {
+        model->meshes.push_back(std::move(*mesh));
+    }
+    else {
+        Assimp::Importer importer;
+        const aiScene *scene = importer.ReadFile(file,
+                                                 aiProcess_Triangulate |
+                                                 aiProcess_FlipUVs |
+                                                 aiProcess_JoinIdenticalVertices |
+                                                 aiProcess_GenSmoothNormals | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph);
+        if (!scene || !scene->mRootNode) {
+            throw std::runtime_error("Couldn't import " + file);
+        }
+    
+        aiNode* rootNode = scene->mRootNode;
+        model->ProcessNode(rootNode, scene);
+    }
+    model->Weld();
+    model->Simplify(ACD_SIMPLIFY_TARGET_TRIANGLES);
+    model->SetHullBudget(ACD_MAX_HULL_VERTICES, ACD_MAX_HULL_FACES, 0.0f);
+    return model;
+}
+
+// Assets the farm already decomposed take their hulls from the cache instead.
+std::shared_ptr<RObject> Model::Load(std::string assetPath, std::function<void(float progress)> onProgress) {
+    
+    std::shared_ptr<Model> model = ImportFile(assetPath);
+    std::vector<ConvexHull> cached;
+    if (LoadDecompositionCache(assetPath, cached)) {
+        model->SetConvexHulls(std::move(cached));
+    }
+    else {
+        model->DecomposeProgressive(ACD_ASSET_MAX_CLUSTERS, ACD_PROGRESSIVE_BUDGET_MS, onProgress);
+    }
+    
+    assetRegistry.Register(assetPath, model);
+    return model;
+}
+
+// Staged load: import and parsing run as a pool task, which then starts the decomposition on the pool,
+// or reads the cached hulls, and posts the first GPU upload to uploadQueue. The future resolves on the GL thread once the coarse
+// hulls are uploaded; refinements arrive later through AssetRegistry::Update. Call from the GL thread.
+// onProgress runs on a pool thread, and only for the call that starts the load.
+AssetFuture Model::LoadAsync(std::string assetPath, std::function<void(float progress)> onProgress = nullptr) {
+    
+    if (std::shared_ptr<const RObject> prototype = assetRegistry.Find(assetPath)) {
+        std::promise<std::shared_ptr<const RObject>> loaded;
+        loaded.set_value(prototype);
+        return loaded.get_future().share();
+    }
+    
+    AssetFuture pending = assetRegistry.FindPending(assetPath);
+    if (pending.valid()) return pending;
+    
+    std::shared_ptr<std::promise<std::shared_ptr<const RObject>>> promise = std::make_shared<std::promise<std::shared_ptr<const RObject>>>();
+    AssetFuture future = promise->get_future().share();
+    assetRegistry.AddPending(assetPath, future);
+    
+    // A failure at any stage fails the future instead of escaping the pool thread or the upload queue
+    auto fail = [assetPath, promise](std::exception_ptr error) {
+        assetRegistry.ClearPending(assetPath);
+        promise->set_exception(error);
+    };
+    
+    threadPool.Enqueue([assetPath, onProgress, promise, fail]() {
+        std::shared_ptr<Model> model;
+        std::shared_ptr<std::vector<ConvexHull>> cached = std::make_shared<std::vector<ConvexHull>>();
+        try {
+            model = ImportFile(assetPath);
+            if (!LoadDecompositionCache(assetPath, *cached)) {
+                cached.reset();
+                model->StartDecomposition(ACD_ASSET_MAX_CLUSTERS, onProgress);
+            }
+        }
+        catch (...) {
+            uploadQueue.Post([fail, error = std::current_exception()]() { fail(error); });
+            return;
+        }
+        
+        uploadQueue.Post([assetPath, promise, model, cached, fail]() {
+            try {
+                if (cached) model->SetConvexHulls(std::move(*cached));
+                else model->ApplyDecompositionSnapshot();
+            }
+            catch (...) {
+                model->CancelDecomposition();
+                fail(std::current_exception());
+                return;
+            }
+            assetRegistry.Register(assetPath, model);
+            promise->set_value(model);
+        });
+    });
+    return future;
+}
+
 void Model::ProcessNode(aiNode *node, const aiScene *scene) {
     for (int i = 0; i < node->mNumMeshes; i++) {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
@@ -95,28 +206,32 @@ void Model::ProcessMesh(aiMesh *mesh, const aiScene *scene) {
 
 void Model::Render(Shader shader) {
     
+    if (!prototype) ApplyDecompositionSnapshot();
+    
     shader.Use();
-    glm::mat4 model = CreateModelMatrix();
-    shader.SetMatrix4("model", model);
+    glm::mat4 modelMatrix = CreateModelMatrix();
+    shader.SetMatrix4("model", modelMatrix);
     
     Ray ray{};
     ray.origin = camera.position;
     ray.direction = camera.mouseRayDirection;
     
-    glm::mat4 modelMatrix = CreateModelMatrix();
+    std::optional<HullTreeHit> hit = RaycastHulls(ray);
     
-    for (Mesh mesh : processedMeshes) {
-        
-        std::optional<Intersection> intersect = Raycast(ray, GetTransformedVertices(mesh, modelMatrix), mesh.indices);
+    // Pieces are culled against the frustum moved into model space, on the boxes from decomposition time
+    Frustum frustum = TransformFrustum(ExtractFrustum(camera.projection * camera.lookAt), modelMatrix);
+    CullBounds(frustum, GetPieceBounds(), visiblePieces);
+    
+    // The hull buffers are uploaded once when created and shared by every instance
+    const std::vector<Mesh>& pieces = GetProcessedMeshes();
+    for (size_t i = 0; i < pieces.size(); i++) {
+        if (i < visiblePieces.size() && !visiblePieces[i]) continue;
+        const Mesh& mesh = pieces[i];
         
         glBindVertexArray(mesh.vao);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), &mesh.vertices[0], GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), &mesh.indices[0], GL_STATIC_DRAW);
         
         shader.SetVector3("color", mesh.color);
-        if (intersect) {
+        if (hit && hit->piece == (int)i) {
             shader.SetVector3("color", glm::vec3(1.0f, 0.0f, 0.0f));
         }
         
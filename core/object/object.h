@@ -9,47 +9,161 @@
 #define object_h
 
 #include <future>
+#include <mutex>
+
+#define ACD_CONCAVITY_THRESHOLD 0.02f
+#define ACD_CLUSTERING_BYTES_PER_TRIANGLE 1536
+#define ACD_MIN_REGION_TRIANGLES 4096
+
+// What Decompose keeps of each mesh so an edit only has to redo the clusters it touched. Piece i of the
+// graph is convexHulls[firstPiece + i] / processedMeshes[firstPiece + i].
+typedef struct decompositionGraph {
+    std::vector<ConcavityCluster> clusters;
+    std::vector<std::set<uint32_t>> neighbors;
+    std::vector<uint32_t> triangleCluster;
+    size_t firstPiece;
+    int maxClusters;
+    float threshold;
+} DecompositionGraph;
+
+// A complete set of pieces produced off the render thread. hullMeshes are CPU-side only; the GL upload
+// happens when the render thread applies the snapshot. graphs is only filled for full-resolution results.
+typedef struct decompositionSnapshot {
+    std::vector<ConvexHull> hulls;
+    std::vector<Mesh> hullMeshes;
+    std::vector<CollisionHull> collisionHulls;
+    HullTree hullTree;
+    BoundsArray pieceBounds;
+    HullBlob hullBlob;
+    std::vector<DecompositionGraph> graphs;
+    float progress;
+    bool final;
+} DecompositionSnapshot;
+
+// Handle to a background decomposition. Cancel() is the cancellation token; onProgress is called on the
+// worker thread with the overall progress in [0, 1]. GetError() holds what the worker threw, if it did.
+class DecompositionTask {
+public:
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> finished{false};
+    std::atomic<float> progress{0.0f};
+    std::function<void(float progress)> onProgress;
+    
+    void Cancel() { cancelled = true; }
+    void ReportProgress(float fraction);
+    void Publish(std::shared_ptr<DecompositionSnapshot> snapshot);
+    bool WaitForSnapshot(double milliseconds);
+    std::exception_ptr GetError();
+    
+private:
+    friend class RObject;
+    std::shared_ptr<DecompositionSnapshot> snapshot;
+    std::exception_ptr error;
+    float levelStart = 0.0f, levelSpan = 1.0f;
+    int publishedSnapshots = 0;
+    std::mutex mutex;
+    std::condition_variable published;
+};
 
 class RObject {
 public:
     std::vector<Mesh> meshes;
     std::vector<Mesh> processedMeshes;
+    std::vector<ConvexHull> convexHulls;
+    std::vector<CollisionHull> collisionHulls;
+    HullTree hullTree;
+    BoundsArray pieceBounds;
+    HullBlob hullBlob;
+    std::vector<DecompositionGraph> decompositions;
     
     int vao, vbo, ibo;
     glm::vec3 position, scale, rotation, color;
     
+    // Instances of a registered asset leave their own geometry empty and read it from the shared prototype
+    std::shared_ptr<const RObject> prototype;
+    
     static RObject* Create();
     virtual void Render(Shader shader) {}
+    virtual ~RObject();
+    
+    const std::vector<Mesh>& GetProcessedMeshes() const { return prototype ? prototype->processedMeshes : processedMeshes; }
+    const std::vector<ConvexHull>& GetConvexHulls() const { return prototype ? prototype->convexHulls : convexHulls; }
+    const std::vector<CollisionHull>& GetCollisionHulls() const { return prototype ? prototype->collisionHulls : collisionHulls; }
+    const HullTree& GetHullTree() const { return prototype ? prototype->hullTree : hullTree; }
+    const BoundsArray& GetPieceBounds() const { return prototype ? prototype->pieceBounds : pieceBounds; }
+    const HullBlob& GetHullBlob() const { return prototype ? prototype->hullBlob : hullBlob; }
     
     
+    void Weld(float tolerance);
+    void Simplify(size_t targetTriangles, float maxError);
     void Decompose(int maxClusters);
+    std::vector<ConvexHull> ComputeDecomposition(int maxClusters);
+    void UpdateDecomposition(size_t meshIndex, const MeshEdit& edit);
+    std::shared_ptr<DecompositionTask> StartDecomposition(int maxClusters, std::function<void(float progress)> onProgress);
+    std::shared_ptr<DecompositionTask> DecomposeProgressive(int maxClusters, double budgetMilliseconds, std::function<void(float progress)> onProgress);
+    bool ApplyDecompositionSnapshot();
+    void CancelDecomposition();
+    void SetHullBudget(int maxVertices, int maxFaces, float skinWidth);
+    HullSimplificationReport SimplifyHulls(int maxVertices, int maxFaces, float skinWidth);
+    void BuildCollisionHulls();
+    void SetConvexHulls(std::vector<ConvexHull> hulls);
+    std::optional<HullTreeHit> RaycastHulls(const Ray& ray, float maxDistance);
     
     glm::mat4 CreateModelMatrix();
     Mesh CreateOpenGLMesh(Mesh convexMesh);
+    Mesh UploadHullMesh(const Mesh& hullMesh);
+    static ConvexHull ComputeConvexHull(const std::vector<glm::vec3>& points);
     
 private:
-    ConvexHull ComputeConvexHull(const std::vector<glm::vec3>& points);
-    std::vector<ConvexHull> ApproximateConvexDecomposition(const Mesh& mesh);
-    bool IsNeighbor(const Triangle& T1, const Triangle& T2);
-    void CollectConvexPiece(const std::vector<Triangle>& triangles, int startIndex, std::set<int>& visitedTriangles, std::set<int>& convexPiece, std::vector<glm::vec3>& points);
+    int hullVertexBudget = 0, hullFaceBudget = 0;
+    float hullSkinWidth = 0.0f;
+    std::shared_ptr<DecompositionTask> decompositionTask;
+    
+    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    glm::vec3 modelPosition, modelRotation, modelScale;
+    bool modelMatrixValid = false;
+    
+    static std::vector<DecompositionGraph> DecomposeMeshes(std::vector<Mesh>& meshes, int maxClusters, std::vector<MeshInstance>& instances);
+    static DecompositionGraph ApproximateConvexDecomposition(const Mesh& mesh, int maxClusters, DecompositionTask* task);
+    static std::vector<std::vector<uint32_t>> SplitClusteringRegions(const std::vector<glm::vec3>& positions, const std::vector<Triangle>& triangles, size_t maxTriangles);
+    static std::vector<ConcavityCluster> MergeClusters(const std::vector<glm::vec3>& positions, const std::vector<Triangle>& triangles,
+                                                       const std::vector<uint32_t>& region, size_t maxClusters, float threshold, DecompositionTask* task);
+    static std::shared_ptr<DecompositionSnapshot> CreateDecompositionSnapshot(std::vector<DecompositionGraph>& graphs, int maxVertices, int maxFaces, float skinWidth);
+    static std::vector<Triangle> GetMeshTriangles(const Mesh& mesh);
+    static void BuildTriangleAdjacency(std::vector<Triangle>& triangles);
+    static void LinkDecompositionGraph(DecompositionGraph& graph, const std::vector<Triangle>& triangles);
+    static DecompositionGraph TransformDecompositionGraph(const DecompositionGraph& graph, const glm::mat4& transform);
+    static std::vector<std::pair<uint32_t, uint32_t>> GetAdjacentPieces(const std::vector<DecompositionGraph>& graphs);
+    static BoundsArray CreatePieceBounds(const std::vector<CollisionHull>& hulls);
+    static Mesh CreateHullMesh(const ConvexHull& hull, glm::vec3 color);
+    static glm::vec3 PieceColor(size_t piece);
 };
 
 
 
 // ------------------------------------------------------------------------------------------------------------- //
-// ComputeConvexHull //
+// ~RObject //
 // ------------------------------------------------------------------------------------------------------------- //
 
-ConvexHull RObject::ComputeConvexHull(const std::vector<glm::vec3> &points) {
+// Instances own no GL objects; prototypes and standalone objects release their hull buffers here.
+RObject::~RObject() {
     
-    ConvexHull hull;
-    
-    for (const auto& P : points) {
-        hull.vertices.push_back(P);
+    CancelDecomposition();
+    for (Mesh& processed : processedMeshes) {
+        glDeleteVertexArrays(1, &processed.vao);
+        glDeleteBuffers(1, &processed.vbo);
+        glDeleteBuffers(1, &processed.ibo);
     }
-    hull.faces.push_back({0, 1, 2});
-    
-    return hull;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// ComputeConvexHull //
+// ------------------------------------------------------------------------------------------------------------- //
+
+ConvexHull RObject::ComputeConvexHull(const std::vector<glm::vec3> &points) {
+    return BuildConvexHull(points);
 }
 
 
@@ -58,94 +172,885 @@ ConvexHull RObject::ComputeConvexHull(const std::vector<glm::vec3> &points) {
 // ApproximateConvexDecomposition //
 // ------------------------------------------------------------------------------------------------------------- //
 
-std::vector<ConvexHull> RObject::ApproximateConvexDecomposition(const Mesh& mesh) {
+DecompositionGraph RObject::ApproximateConvexDecomposition(const Mesh& mesh, int maxClusters, DecompositionTask* task = nullptr) {
     
-    std::vector<Triangle> triangles;
-    std::vector<ConvexHull> convexHulls;
+    std::vector<glm::vec3> positions = GetMeshPositions(mesh);
+    
+    // Step 1: Collect the triangles and form the neighborhood relationships
+    std::vector<Triangle> triangles = GetMeshTriangles(mesh);
+    BuildTriangleAdjacency(triangles);
+    
+    glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX);
+    for (const glm::vec3& P : positions) {
+        boundsMin = glm::min(boundsMin, P);
+        boundsMax = glm::max(boundsMax, P);
+    }
+    
+    DecompositionGraph graph;
+    graph.firstPiece = 0;
+    graph.maxClusters = maxClusters;
+    graph.threshold = positions.empty() ? 0.0f : ACD_CONCAVITY_THRESHOLD * glm::length(boundsMax - boundsMin);
+    
+    // Step 2: Cluster. When the memory budget can't hold the clusters and candidates of every triangle at
+    // once, the triangles are clustered region by region, so only one region's worth is alive at a time.
+    // Pieces then never cross a region boundary.
+    size_t regionSize = std::max<size_t>(ACD_MIN_REGION_TRIANGLES, GetMemoryHeadroom() / ACD_CLUSTERING_BYTES_PER_TRIANGLE);
+    if (regionSize >= triangles.size()) {
+        std::vector<uint32_t> region(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i++) {
+            region[i] = (uint32_t)i;
+        }
+        graph.clusters = MergeClusters(positions, triangles, region, (size_t)maxClusters, graph.threshold, task);
+    }
+    else {
+        std::vector<std::vector<uint32_t>> regions = SplitClusteringRegions(positions, triangles, regionSize);
+        memoryStats.splitMeshes.fetch_add(1, std::memory_order_relaxed);
+        memoryStats.clusteringRegions.fetch_add(regions.size(), std::memory_order_relaxed);
+        
+        for (const std::vector<uint32_t>& region : regions) {
+            size_t regionClusters = std::max<size_t>(1, (size_t)maxClusters * region.size() / triangles.size());
+            std::vector<ConcavityCluster> clusters = MergeClusters(positions, triangles, region, regionClusters, graph.threshold, task);
+            graph.clusters.insert(graph.clusters.end(), std::make_move_iterator(clusters.begin()), std::make_move_iterator(clusters.end()));
+            if (task && task->cancelled) break;
+        }
+    }
+    LinkDecompositionGraph(graph, triangles);
+    return graph;
+}
+
+// Cuts the triangles into spatially compact regions of at most maxTriangles by median splits of their
+// centroids along the longest axis.
+std::vector<std::vector<uint32_t>> RObject::SplitClusteringRegions(const std::vector<glm::vec3>& positions, const std::vector<Triangle>& triangles, size_t maxTriangles) {
+    
+    std::vector<glm::vec3> centroids(triangles.size());
+    std::vector<uint32_t> order(triangles.size());
+    for (uint32_t i = 0; i < triangles.size(); i++) {
+        const uint32_t* indices = triangles[i].indices;
+        centroids[i] = (positions[indices[0]] + positions[indices[1]] + positions[indices[2]]) / 3.0f;
+        order[i] = i;
+    }
+    
+    std::vector<std::vector<uint32_t>> regions;
+    std::vector<std::pair<size_t, size_t>> stack = {{0, order.size()}};
+    while (!stack.empty()) {
+        auto [begin, end] = stack.back();
+        stack.pop_back();
+        if (end - begin <= std::max<size_t>(maxTriangles, 1)) {
+            if (end > begin) regions.emplace_back(order.begin() + begin, order.begin() + end);
+            continue;
+        }
+        
+        glm::vec3 boundsMin = centroids[order[begin]], boundsMax = boundsMin;
+        for (size_t i = begin; i < end; i++) {
+            boundsMin = glm::min(boundsMin, centroids[order[i]]);
+            boundsMax = glm::max(boundsMax, centroids[order[i]]);
+        }
+        glm::vec3 extent = boundsMax - boundsMin;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                         [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+        stack.push_back({middle, end});
+        stack.push_back({begin, middle});
+    }
+    return regions;
+}
+
+// Clusters the given triangles among themselves; neighbours outside the region are ignored.
+std::vector<ConcavityCluster> RObject::MergeClusters(const std::vector<glm::vec3>& positions, const std::vector<Triangle>& triangles,
+                                                     const std::vector<uint32_t>& region, size_t maxClusters, float threshold, DecompositionTask* task) {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_CLUSTERING);
+    
+    std::vector<int> local(triangles.size(), -1);
+    for (size_t i = 0; i < region.size(); i++) {
+        local[region[i]] = (int)i;
+    }
+    
+    // Step 2: Every triangle starts out as its own cluster
+    std::vector<ConcavityCluster> clusters(region.size());
+    threadPool.ParallelFor(region.size(), 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            clusters[i] = CreateConcavityCluster(positions, triangles[region[i]], region[i]);
+        }
+    });
+    
+    std::vector<std::set<uint32_t>> clusterNeighbors(region.size());
+    std::vector<uint32_t> versions(region.size(), 0);
+    std::vector<bool> alive(region.size(), true);
+    size_t aliveCount = region.size();
+    
+    // hull(A ∪ B) of every candidate pair that is still current. A pair goes stale only when one of its
+    // clusters merges, so the entry is dropped then and the committed merge never builds a hull itself.
+    std::unordered_map<uint64_t, ConvexHull> mergeHulls;
+    auto pairKey = [](uint32_t a, uint32_t b) { return ((uint64_t)std::min(a, b) << 32) | std::max(a, b); };
+    
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+    std::vector<float> costs;
+    std::vector<ConvexHull> hulls;
+    for (size_t i = 0; i < region.size(); i++) {
+        for (uint32_t neighbor : triangles[region[i]].neighbors) {
+            if (local[neighbor] < 0) continue;
+            clusterNeighbors[i].insert((uint32_t)local[neighbor]);
+            if ((int)i < local[neighbor]) candidates.push_back({(uint32_t)i, (uint32_t)local[neighbor]});
+        }
+    }
+    EvaluateMergeCosts(clusters, candidates, costs, hulls);
+    
+    std::priority_queue<MergeCandidate, std::vector<MergeCandidate>, std::greater<MergeCandidate>> queue;
+    mergeHulls.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        queue.push({costs[i], candidates[i].first, candidates[i].second, 0, 0});
+        mergeHulls[pairKey(candidates[i].first, candidates[i].second)] = std::move(hulls[i]);
+    }
+    
+    // Step 3: Greedily merge the least concave pair until the cluster budget is met and every remaining merge is too concave
+    while (!queue.empty()) {
+        
+        if (task) {
+            if (task->cancelled) break;
+            task->ReportProgress((float)(region.size() - aliveCount) / std::max<size_t>(region.size() - std::min(region.size(), maxClusters), 1));
+        }
+        
+        MergeCandidate candidate = queue.top();
+        if (aliveCount <= maxClusters && candidate.cost > threshold) break;
+        queue.pop();
+        
+        uint32_t a = candidate.clusterA, b = candidate.clusterB;
+        if (!alive[a] || !alive[b] || versions[a] != candidate.versionA || versions[b] != candidate.versionB) continue;
+        
+        ConvexHull hull;
+        auto cached = mergeHulls.find(pairKey(a, b));
+        if (cached != mergeHulls.end()) hull = std::move(cached->second);
+        else hull = MergeConvexHulls(clusters[a].hull, clusters[b].hull);
+        
+        for (uint32_t neighbor : clusterNeighbors[a]) mergeHulls.erase(pairKey(a, neighbor));
+        for (uint32_t neighbor : clusterNeighbors[b]) mergeHulls.erase(pairKey(b, neighbor));
+        
+        clusters[a] = MergeConcavityClusters(clusters[a], clusters[b], std::move(hull));
+        clusters[b] = ConcavityCluster();
+        alive[b] = false;
+        aliveCount--;
+        versions[a]++;
+        
+        for (uint32_t neighbor : clusterNeighbors[b]) {
+            if (neighbor == a) continue;
+            clusterNeighbors[neighbor].erase(b);
+            clusterNeighbors[neighbor].insert(a);
+            clusterNeighbors[a].insert(neighbor);
+        }
+        clusterNeighbors[a].erase(b);
+        clusterNeighbors[b].clear();
+        
+        candidates.clear();
+        for (uint32_t neighbor : clusterNeighbors[a]) {
+            candidates.push_back({a, neighbor});
+        }
+        EvaluateMergeCosts(clusters, candidates, costs, hulls);
+        
+        for (size_t i = 0; i < candidates.size(); i++) {
+            uint32_t neighbor = candidates[i].second;
+            queue.push({costs[i], a, neighbor, versions[a], versions[neighbor]});
+            mergeHulls[pairKey(a, neighbor)] = std::move(hulls[i]);
+        }
+    }
+    
+    std::vector<ConcavityCluster> convexPieces;
+    for (size_t i = 0; i < clusters.size(); i++) {
+        if (alive[i]) convexPieces.push_back(std::move(clusters[i]));
+    }
+    return convexPieces;
+}
+
+std::vector<Triangle> RObject::GetMeshTriangles(const Mesh& mesh) {
     
-    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    MemoryStageScope memoryStage(MEMORY_STAGE_ADJACENCY);
+    std::vector<Triangle> triangles;
+    triangles.reserve(mesh.indices.size() / 3);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
         Triangle t;
         t.indices[0] = mesh.indices[i];
         t.indices[1] = mesh.indices[i + 1];
         t.indices[2] = mesh.indices[i + 2];
         triangles.push_back(t);
     }
+    return triangles;
+}
+
+// Derives the triangle -> cluster map and the cluster adjacency from the triangle adjacency.
+void RObject::LinkDecompositionGraph(DecompositionGraph& graph, const std::vector<Triangle>& triangles) {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_CLUSTERING);
+    graph.triangleCluster.assign(triangles.size(), 0);
+    for (uint32_t i = 0; i < graph.clusters.size(); i++) {
+        for (uint32_t triangle : graph.clusters[i].triangles) {
+            graph.triangleCluster[triangle] = i;
+        }
+    }
+    
+    graph.neighbors.assign(graph.clusters.size(), {});
+    for (uint32_t i = 0; i < triangles.size(); i++) {
+        for (uint32_t neighbor : triangles[i].neighbors) {
+            uint32_t a = graph.triangleCluster[i], b = graph.triangleCluster[neighbor];
+            if (a != b) graph.neighbors[a].insert(b);
+        }
+    }
+}
 
-    // Step 2: Form the neighborhood relationships
-    for (size_t i = 0; i < triangles.size(); ++i) {
-        for (size_t j = i + 1; j < triangles.size(); ++j) {
+// The graph of a congruent copy of graph's mesh. Triangle and vertex indices carry over unchanged, since
+// copies share their index buffer.
+DecompositionGraph RObject::TransformDecompositionGraph(const DecompositionGraph& graph, const glm::mat4& transform) {
+    
+    DecompositionGraph moved;
+    moved.neighbors = graph.neighbors;
+    moved.triangleCluster = graph.triangleCluster;
+    moved.firstPiece = 0;
+    moved.maxClusters = graph.maxClusters;
+    moved.threshold = graph.threshold;
+    
+    moved.clusters.resize(graph.clusters.size());
+    threadPool.ParallelFor(graph.clusters.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            moved.clusters[i] = TransformCluster(graph.clusters[i], transform);
+        }
+    });
+    return moved;
+}
+
+// ------------------------------------------------------------------------------------------------------------- //
+// BuildTriangleAdjacency //
+// ------------------------------------------------------------------------------------------------------------- //
 
-            if (IsNeighbor(triangles[i], triangles[j])) {
-                triangles[i].neighbors.insert(j);
-                triangles[j].neighbors.insert(i);
+// Two triangles are neighbours when they share an edge.
+void RObject::BuildTriangleAdjacency(std::vector<Triangle>& triangles) {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_ADJACENCY);
+    std::unordered_map<uint64_t, uint32_t> edgeOwners;
+    edgeOwners.reserve(triangles.size() * 3);
+    
+    for (uint32_t i = 0; i < triangles.size(); i++) {
+        for (int edge = 0; edge < 3; edge++) {
+            uint32_t a = triangles[i].indices[edge];
+            uint32_t b = triangles[i].indices[(edge + 1) % 3];
+            uint64_t key = ((uint64_t)std::min(a, b) << 32) | std::max(a, b);
+            
+            auto owner = edgeOwners.find(key);
+            if (owner == edgeOwners.end()) {
+                edgeOwners[key] = i;
+            }
+            else if (owner->second != i) {
+                triangles[i].neighbors.insert(owner->second);
+                triangles[owner->second].neighbors.insert(i);
             }
         }
     }
+}
 
-    // Step 3: Greedily find convex sub-regions
-    std::set<int> visitedTriangles;
-    for (size_t i = 0; i < triangles.size(); ++i) {
-        if (visitedTriangles.find(i) == visitedTriangles.end()) {
-            
-            std::vector<glm::vec3> points;
-            std::set<int> convexPiece;
-            CollectConvexPiece(triangles, i, visitedTriangles, convexPiece, points);
-            
-            ConvexHull hull = ComputeConvexHull(points);
-            convexHulls.push_back(hull);
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Weld //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Collapses duplicate vertices (uv and normal seams, or raw triangle soups) so triangles that touch
+// share indices. Adjacency, simplification and decomposition all rely on it.
+void RObject::Weld(float tolerance = ACD_WELD_TOLERANCE) {
+    
+    for (Mesh& mesh : meshes) {
+        mesh = WeldMesh(mesh, tolerance);
+    }
+}
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Simplify //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Optional pre-pass before Decompose; convex hulls don't need the fine detail. The triangle budget is
+// shared between the meshes in proportion to their size.
+void RObject::Simplify(size_t targetTriangles, float maxError = FLT_MAX) {
+    
+    size_t totalTriangles = 0;
+    for (const Mesh& mesh : meshes) {
+        totalTriangles += mesh.indices.size() / 3;
+    }
+    if (totalTriangles <= targetTriangles) return;
+    
+    for (Mesh& mesh : meshes) {
+        size_t meshTarget = (size_t)((double)targetTriangles * (mesh.indices.size() / 3) / totalTriangles);
+        mesh = SimplifyMesh(mesh, meshTarget, maxError);
+    }
+}
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// Decompose //
+// ------------------------------------------------------------------------------------------------------------- //
+
+void RObject::Decompose(int maxClusters = 10) {
+    
+    CancelDecomposition();
+    processedMeshes.clear();
+    convexHulls.clear();
+    
+    std::vector<MeshInstance> instances;
+    decompositions = DecomposeMeshes(meshes, maxClusters, instances);
+        
+    for (size_t i = 0; i < decompositions.size(); i++) {
+        
+        DecompositionGraph& graph = decompositions[i];
+        graph.firstPiece = convexHulls.size();
+        
+        for (ConcavityCluster& piece : graph.clusters) {
+            convexHulls.push_back(std::move(piece.hull));
         }
     }
+    
+    // Same hull budget as every other decomposition path
+    if (hullVertexBudget > 0) {
+        MemoryStageScope memoryStage(MEMORY_STAGE_HULLS);
+        threadPool.ParallelFor(convexHulls.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) convexHulls[i] = SimplifyHull(convexHulls[i], hullVertexBudget, hullFaceBudget, hullSkinWidth);
+        });
+    }
+    for (size_t i = 0; i < convexHulls.size(); i++) {
+        processedMeshes.push_back(UploadHullMesh(CreateHullMesh(convexHulls[i], PieceColor(i))));
+    }
+    BuildCollisionHulls();
+}
 
-    return convexHulls;
+// Triangle soups are welded first, since they have no shared indices and would come out with no neighbours
+// at all. Repeated geometry is decomposed once and its pieces moved onto every copy.
+std::vector<DecompositionGraph> RObject::DecomposeMeshes(std::vector<Mesh>& meshes, int maxClusters, std::vector<MeshInstance>& instances) {
+    
+    for (Mesh& mesh : meshes) {
+        if (mesh.indices.empty()) mesh = WeldMesh(mesh);
+    }
+    
+    std::vector<DecompositionGraph> graphs;
+    instances = FindCongruentMeshes(meshes);
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const MeshInstance& instance = instances[i];
+        if (instance.source == i) graphs.push_back(ApproximateConvexDecomposition(meshes[i], maxClusters));
+        else graphs.push_back(TransformDecompositionGraph(graphs[instance.source], instance.transform));
+    }
+    return graphs;
+}
+
+// Decompose without any GL: the pieces of every mesh in order, cut down to the hull budget. For tools and
+// worker processes that only write the hulls out.
+std::vector<ConvexHull> RObject::ComputeDecomposition(int maxClusters) {
+    
+    std::vector<MeshInstance> instances;
+    std::vector<DecompositionGraph> graphs = DecomposeMeshes(meshes, maxClusters, instances);
+    
+    std::vector<ConvexHull> hulls;
+    for (DecompositionGraph& graph : graphs) {
+        for (ConcavityCluster& cluster : graph.clusters) {
+            hulls.push_back(std::move(cluster.hull));
+        }
+    }
+    if (hullVertexBudget > 0) {
+        MemoryStageScope memoryStage(MEMORY_STAGE_HULLS);
+        threadPool.ParallelFor(hulls.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) hulls[i] = SimplifyHull(hulls[i], hullVertexBudget, hullFaceBudget, hullSkinWidth);
+        });
+    }
+    return hulls;
+}
+
+glm::vec3 RObject::PieceColor(size_t piece) {
+    float hue = std::fmod(piece * 0.618034f, 1.0f) * 6.28318f;
+    return glm::vec3(0.5f + 0.5f * cos(hue), 0.5f + 0.5f * cos(hue + 2.0944f), 0.5f + 0.5f * cos(hue + 4.1888f));
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// UpdateDecomposition //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Re-decomposes only the part of meshes[meshIndex] covered by edit. Clusters holding an edited triangle,
+// or a triangle on an edited vertex, are thrown away together with their direct neighbours, and their
+// triangles are clustered again on their own. Every other piece keeps its hull and GL buffers.
+void RObject::UpdateDecomposition(size_t meshIndex, const MeshEdit& edit) {
+    
+    if (meshIndex >= decompositions.size()) return;
+    
+    DecompositionGraph& graph = decompositions[meshIndex];
+    const Mesh& mesh = meshes[meshIndex];
+    
+    std::vector<glm::vec3> positions = GetMeshPositions(mesh);
+    std::vector<Triangle> triangles = GetMeshTriangles(mesh);
+    BuildTriangleAdjacency(triangles);
+    
+    // Step 1: Find the clusters the edit touched
+    std::vector<uint8_t> dirty(graph.clusters.size(), 0);
+    std::vector<uint8_t> assigned(triangles.size(), 0);
+    auto touches = [&](uint32_t triangle) {
+        if (triangle >= edit.firstTriangle && triangle - edit.firstTriangle < edit.triangleCount) return true;
+        for (int i = 0; i < 3; i++) {
+            uint32_t vertex = triangles[triangle].indices[i];
+            if (vertex >= edit.firstVertex && vertex - edit.firstVertex < edit.vertexCount) return true;
+        }
+        return false;
+    };
+    for (uint32_t triangle = 0; triangle < triangles.size() && triangle < graph.triangleCluster.size(); triangle++) {
+        if (touches(triangle)) dirty[graph.triangleCluster[triangle]] = 1;
+    }
+    for (size_t i = 0; i < graph.clusters.size(); i++) {
+        for (uint32_t triangle : graph.clusters[i].triangles) {
+            if (triangle >= triangles.size()) dirty[i] = 1;
+        }
+        if (!graph.clusters[i].vertices.empty() && graph.clusters[i].vertices.back() >= positions.size()) dirty[i] = 1;
+    }
+    
+    // Step 2: Widen to their neighbours so the new clusters have room to settle differently
+    std::vector<uint8_t> invalid = dirty;
+    for (size_t i = 0; i < graph.clusters.size(); i++) {
+        if (!dirty[i]) continue;
+        for (uint32_t neighbor : graph.neighbors[i]) {
+            invalid[neighbor] = 1;
+        }
+    }
+    
+    // Step 3: Re-cluster the freed triangles and any triangles the old graph has never seen
+    std::vector<uint32_t> region;
+    size_t invalidCount = 0;
+    for (size_t i = 0; i < graph.clusters.size(); i++) {
+        for (uint32_t triangle : graph.clusters[i].triangles) {
+            if (triangle >= triangles.size()) continue;
+            assigned[triangle] = 1;
+            if (invalid[i]) region.push_back(triangle);
+        }
+        invalidCount += invalid[i];
+    }
+    for (uint32_t triangle = 0; triangle < triangles.size(); triangle++) {
+        if (!assigned[triangle]) region.push_back(triangle);
+    }
+    if (region.empty() && invalidCount == 0) return;
+    
+    std::vector<ConcavityCluster> rebuilt = MergeClusters(positions, triangles, region, std::max(invalidCount, (size_t)1), graph.threshold, nullptr);
+    
+    // Step 4: Splice the kept and rebuilt pieces back into this mesh's range of the piece arrays
+    std::vector<ConcavityCluster> clusters;
+    std::vector<ConvexHull> hulls;
+    std::vector<Mesh> pieces;
+    for (size_t i = 0; i < graph.clusters.size(); i++) {
+        Mesh& processed = processedMeshes[graph.firstPiece + i];
+        if (invalid[i]) {
+            glDeleteVertexArrays(1, &processed.vao);
+            glDeleteBuffers(1, &processed.vbo);
+            glDeleteBuffers(1, &processed.ibo);
+            continue;
+        }
+        clusters.push_back(std::move(graph.clusters[i]));
+        hulls.push_back(std::move(convexHulls[graph.firstPiece + i]));
+        pieces.push_back(processed);
+    }
+    
+    std::vector<ConvexHull> rebuiltHulls(rebuilt.size());
+    threadPool.ParallelFor(rebuilt.size(), 4, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            rebuiltHulls[i] = std::move(rebuilt[i].hull);
+            if (hullVertexBudget > 0) rebuiltHulls[i] = SimplifyHull(rebuiltHulls[i], hullVertexBudget, hullFaceBudget, hullSkinWidth);
+        }
+    });
+    for (size_t i = 0; i < rebuilt.size(); i++) {
+        pieces.push_back(UploadHullMesh(CreateHullMesh(rebuiltHulls[i], PieceColor(graph.firstPiece + hulls.size()))));
+        hulls.push_back(std::move(rebuiltHulls[i]));
+        clusters.push_back(std::move(rebuilt[i]));
+    }
+    
+    size_t oldCount = graph.clusters.size();
+    convexHulls.erase(convexHulls.begin() + graph.firstPiece, convexHulls.begin() + graph.firstPiece + oldCount);
+    convexHulls.insert(convexHulls.begin() + graph.firstPiece, std::make_move_iterator(hulls.begin()), std::make_move_iterator(hulls.end()));
+    processedMeshes.erase(processedMeshes.begin() + graph.firstPiece, processedMeshes.begin() + graph.firstPiece + oldCount);
+    processedMeshes.insert(processedMeshes.begin() + graph.firstPiece, pieces.begin(), pieces.end());
+    for (size_t i = meshIndex + 1; i < decompositions.size(); i++) {
+        decompositions[i].firstPiece = decompositions[i].firstPiece + clusters.size() - oldCount;
+    }
+    
+    graph.clusters = std::move(clusters);
+    LinkDecompositionGraph(graph, triangles);
+    BuildCollisionHulls();
 }
 
 // ------------------------------------------------------------------------------------------------------------- //
-// CollectConvexPiece //
+// DecomposeProgressive //
 // ------------------------------------------------------------------------------------------------------------- //
 
-void RObject::CollectConvexPiece(const std::vector<Triangle> &triangles, int startIndex, std::set<int> &visitedTriangles, std::set<int> &convexPiece, std::vector<glm::vec3> &points) {
+void DecompositionTask::ReportProgress(float fraction) {
     
-    convexPiece.insert(startIndex);
-    visitedTriangles.insert(startIndex);
-    const Triangle& t = triangles[startIndex];
+    float overall = levelStart + levelSpan * std::min(std::max(fraction, 0.0f), 1.0f);
+    if (overall <= progress || (overall - progress < 0.01f && overall < 1.0f)) return;
+    progress = overall;
+    if (onProgress) onProgress(overall);
+}
+
+void DecompositionTask::Publish(std::shared_ptr<DecompositionSnapshot> next) {
     
-    for (int i = 0; i < 3; ++i) {
-        points.push_back(glm::vec3(t.indices[i]));
+    std::atomic_store(&snapshot, next);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        publishedSnapshots++;
     }
+    published.notify_all();
+    ReportProgress(1.0f);
+}
+
+// Waits until a snapshot beyond the initial one has been published, the task ends, or the time is up.
+bool DecompositionTask::WaitForSnapshot(double milliseconds) {
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    return published.wait_for(lock, std::chrono::duration<double, std::milli>(milliseconds), [this] { return publishedSnapshots > 1 || finished; });
+}
+
+std::exception_ptr DecompositionTask::GetError() {
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    return error;
+}
+
+std::shared_ptr<DecompositionSnapshot> RObject::CreateDecompositionSnapshot(std::vector<DecompositionGraph>& graphs, int maxVertices, int maxFaces, float skinWidth) {
     
-    for (int neighbor : t.neighbors) {
-        if (visitedTriangles.find(neighbor) == visitedTriangles.end()) {
-            CollectConvexPiece(triangles, neighbor, visitedTriangles, convexPiece, points);
+    MemoryStageScope memoryStage(MEMORY_STAGE_HULLS);
+    std::shared_ptr<DecompositionSnapshot> snapshot = std::make_shared<DecompositionSnapshot>();
+    for (DecompositionGraph& graph : graphs) {
+        graph.firstPiece = snapshot->hulls.size();
+        for (ConcavityCluster& cluster : graph.clusters) {
+            snapshot->hulls.push_back(std::move(cluster.hull));
         }
     }
+    
+    size_t count = snapshot->hulls.size();
+    snapshot->hullMeshes.resize(count);
+    snapshot->collisionHulls.resize(count);
+    threadPool.ParallelFor(count, 4, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (maxVertices > 0) snapshot->hulls[i] = SimplifyHull(snapshot->hulls[i], maxVertices, maxFaces, skinWidth);
+            snapshot->hullMeshes[i] = CreateHullMesh(snapshot->hulls[i], PieceColor(i));
+            snapshot->collisionHulls[i] = CreateCollisionHull(snapshot->hulls[i]);
+        }
+    });
+    snapshot->pieceBounds = CreatePieceBounds(snapshot->collisionHulls);
+    snapshot->hullBlob = HullBlob::Create(snapshot->hulls);
+    if (maxVertices > 0) snapshot->hullTree.Build(snapshot->hulls, GetAdjacentPieces(graphs), maxVertices, maxFaces);
+    else snapshot->hullTree.Build(snapshot->hulls, GetAdjacentPieces(graphs));
+    snapshot->progress = 0.0f;
+    snapshot->final = false;
+    return snapshot;
 }
 
-bool RObject::IsNeighbor(const Triangle& T1, const Triangle& T2) {
+// Publishes one hull per mesh right away, then decomposes the meshes on the thread pool at increasing
+// resolution (1/64, 1/8, then all of their triangles), publishing every level as it completes. Touches
+// no GL state, so it can run on a loader thread; ApplyDecompositionSnapshot does the upload.
+std::shared_ptr<DecompositionTask> RObject::StartDecomposition(int maxClusters, std::function<void(float progress)> onProgress = nullptr) {
+    
+    CancelDecomposition();
+    
+    std::shared_ptr<DecompositionTask> task = std::make_shared<DecompositionTask>();
+    task->onProgress = onProgress;
+    decompositionTask = task;
     
-    std::set<uint32_t> edges1 = {T1.indices[0], T1.indices[1], T1.indices[1], T1.indices[2], T1.indices[2], T1.indices[0]};
-    std::set<uint32_t> edges2 = {T2.indices[0], T2.indices[1], T2.indices[1], T2.indices[2], T2.indices[2], T2.indices[0]};
+    for (Mesh& mesh : meshes) {
+        if (mesh.indices.empty()) mesh = WeldMesh(mesh);
+    }
+    
+    std::vector<MeshInstance> instances = FindCongruentMeshes(meshes);
     
-    for (auto edge1 : edges1) {
-        for (auto edge2 : edges2) {
-            if (edge1 == edge2) {
-                return true;
+    std::vector<DecompositionGraph> coarse;
+    size_t totalTriangles = 0;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        DecompositionGraph graph;
+        ConcavityCluster cluster;
+        if (instances[i].source == i) {
+            cluster.hull = BuildConvexHull(GetMeshPositions(meshes[i]));
+            totalTriangles += meshes[i].indices.size() / 3;
+        }
+        else {
+            cluster.hull = TransformHull(coarse[instances[i].source].clusters[0].hull, instances[i].transform);
+        }
+        graph.clusters.push_back(std::move(cluster));
+        coarse.push_back(std::move(graph));
+    }
+    task->levelSpan = 0.0f;
+    task->Publish(CreateDecompositionSnapshot(coarse, hullVertexBudget, hullFaceBudget, hullSkinWidth));
+    
+    std::vector<size_t> levels;
+    for (size_t divisor : {64, 8}) {
+        if (totalTriangles / divisor >= 256) levels.push_back(divisor);
+    }
+    levels.push_back(1);
+    
+    // The worker gets its own copy of the meshes so the caller is free to keep editing them
+    threadPool.Enqueue([task, sourceMeshes = meshes, instances, levels, maxClusters, maxVertices = hullVertexBudget, maxFaces = hullFaceBudget, skinWidth = hullSkinWidth]() {
+        
+        // Nothing on a pool thread may throw past here; the error ends the task and the snapshots
+        // already published stay usable
+        try {
+            for (size_t level = 0; level < levels.size() && !task->cancelled; level++) {
+            
+                std::vector<DecompositionGraph> graphs;
+                for (size_t i = 0; i < sourceMeshes.size(); i++) {
+                    if (task->cancelled) break;
+                    task->levelSpan = 1.0f / (levels.size() * sourceMeshes.size());
+                    task->levelStart = (float)level / levels.size() + graphs.size() * task->levelSpan;
+                
+                    // Copies take the source's pieces; at the coarser levels only their hulls are used
+                    if (instances[i].source != i) {
+                        graphs.push_back(TransformDecompositionGraph(graphs[instances[i].source], instances[i].transform));
+                        continue;
+                    }
+                    const Mesh& mesh = sourceMeshes[i];
+                    Mesh source = levels[level] > 1 ? SimplifyMesh(mesh, mesh.indices.size() / 3 / levels[level], FLT_MAX) : mesh;
+                    graphs.push_back(ApproximateConvexDecomposition(source, maxClusters, task.get()));
+                }
+                if (task->cancelled) break;
+            
+                std::shared_ptr<DecompositionSnapshot> snapshot = CreateDecompositionSnapshot(graphs, maxVertices, maxFaces, skinWidth);
+                snapshot->progress = (float)(level + 1) / levels.size();
+                snapshot->final = levels[level] == 1;
+                if (snapshot->final) snapshot->graphs = std::move(graphs);
+                task->Publish(snapshot);
             }
         }
+        catch (...) {
+            std::unique_lock<std::mutex> lock(task->mutex);
+            task->error = std::current_exception();
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(task->mutex);
+            task->finished = true;
+        }
+        task->published.notify_all();
+    });
+    return task;
+}
+    
+// Anytime variant of Decompose. Returns once a level beyond the first hull is in, or after
+// budgetMilliseconds, with the newest snapshot already applied. Later snapshots are picked up by
+// ApplyDecompositionSnapshot.
+std::shared_ptr<DecompositionTask> RObject::DecomposeProgressive(int maxClusters, double budgetMilliseconds = 50.0, std::function<void(float progress)> onProgress = nullptr) {
+    
+    std::shared_ptr<DecompositionTask> task = StartDecomposition(maxClusters, onProgress);
+    task->WaitForSnapshot(budgetMilliseconds);
+    ApplyDecompositionSnapshot();
+    return task;
+}
+
+// Swaps in the newest published snapshot, if any. Must be called on the thread that owns the GL context.
+bool RObject::ApplyDecompositionSnapshot() {
+    
+    if (!decompositionTask) return false;
+    
+    std::shared_ptr<DecompositionSnapshot> snapshot = std::atomic_exchange(&decompositionTask->snapshot, std::shared_ptr<DecompositionSnapshot>());
+    if (!snapshot) return false;
+    
+    for (Mesh& processed : processedMeshes) {
+        glDeleteVertexArrays(1, &processed.vao);
+        glDeleteBuffers(1, &processed.vbo);
+        glDeleteBuffers(1, &processed.ibo);
+    }
+    processedMeshes.clear();
+    for (const Mesh& hullMesh : snapshot->hullMeshes) {
+        processedMeshes.push_back(UploadHullMesh(hullMesh));
     }
-    return false;
+    convexHulls = std::move(snapshot->hulls);
+    collisionHulls = std::move(snapshot->collisionHulls);
+    hullTree = std::move(snapshot->hullTree);
+    pieceBounds = std::move(snapshot->pieceBounds);
+    hullBlob = std::move(snapshot->hullBlob);
+    decompositions = std::move(snapshot->graphs);
+    return true;
+}
+
+// Stops the background decomposition; a snapshot already published but not yet applied is dropped.
+void RObject::CancelDecomposition() {
     
+    if (!decompositionTask) return;
+    decompositionTask->Cancel();
+    decompositionTask.reset();
+}
+
+// A vertex budget of 0 turns simplification off. Any other budget is raised to ACD_MIN_HULL_VERTICES /
+// ACD_MIN_HULL_FACES, the least SimplifyHull can guarantee.
+void RObject::SetHullBudget(int maxVertices, int maxFaces, float skinWidth) {
+    hullVertexBudget = maxVertices > 0 ? std::max(maxVertices, ACD_MIN_HULL_VERTICES) : 0;
+    hullFaceBudget = maxVertices > 0 ? std::max(maxFaces, ACD_MIN_HULL_FACES) : 0;
+    hullSkinWidth = skinWidth;
 }
 
 
+
 // ------------------------------------------------------------------------------------------------------------- //
-// Decompose //
+// SimplifyHulls //
 // ------------------------------------------------------------------------------------------------------------- //
 
-void RObject::Decompose(int maxClusters = 10) {
+// Caps every hull at maxVertices / maxFaces for downstream physics, optionally inflating it by skinWidth.
+// The hulls only ever grow, so the reported error is the extra volume relative to the original hull.
+// A vertex budget of 0 only lifts the budget for later decompositions and leaves the hulls as they are.
+HullSimplificationReport RObject::SimplifyHulls(int maxVertices = ACD_MAX_HULL_VERTICES, int maxFaces = ACD_MAX_HULL_FACES, float skinWidth = 0.0f) {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_HULLS);
+    SetHullBudget(maxVertices, maxFaces, skinWidth);
+    
+    if (maxVertices <= 0) {
+        HullSimplificationReport unchanged{0.0f, 0.0f, 0.0f};
+        for (const ConvexHull& hull : convexHulls) {
+            unchanged.originalVolume += ComputeHullVolume(hull);
+        }
+        unchanged.simplifiedVolume = unchanged.originalVolume;
+        return unchanged;
+    }
+    
+    std::vector<float> originalVolumes(convexHulls.size()), simplifiedVolumes(convexHulls.size());
+    
+    threadPool.ParallelFor(convexHulls.size(), 4, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            originalVolumes[i] = ComputeHullVolume(convexHulls[i]);
+            convexHulls[i] = SimplifyHull(convexHulls[i], maxVertices, maxFaces, skinWidth);
+            simplifiedVolumes[i] = ComputeHullVolume(convexHulls[i]);
+        }
+    });
     
-    for (Mesh mesh : meshes) {
+    HullSimplificationReport report{0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < convexHulls.size(); i++) {
+        report.originalVolume += originalVolumes[i];
+        report.simplifiedVolume += simplifiedVolumes[i];
+        if (originalVolumes[i] > 0.0f) {
+            report.maxVolumeError = std::max(report.maxVolumeError, (simplifiedVolumes[i] - originalVolumes[i]) / originalVolumes[i]);
+        }
         
+        Mesh& processed = processedMeshes[i];
+        glDeleteVertexArrays(1, &processed.vao);
+        glDeleteBuffers(1, &processed.vbo);
+        glDeleteBuffers(1, &processed.ibo);
+        processed = UploadHullMesh(CreateHullMesh(convexHulls[i], processed.color));
+    }
+    
+    BuildCollisionHulls();
+    return report;
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// SetConvexHulls //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Takes hulls decomposed elsewhere, such as a decomposition cache entry, in place of Decompose. They come
+// without decomposition graphs, so UpdateDecomposition has nothing to work from until the next Decompose.
+void RObject::SetConvexHulls(std::vector<ConvexHull> hulls) {
+    
+    CancelDecomposition();
+    for (Mesh& processed : processedMeshes) {
+        glDeleteVertexArrays(1, &processed.vao);
+        glDeleteBuffers(1, &processed.vbo);
+        glDeleteBuffers(1, &processed.ibo);
+    }
+    processedMeshes.clear();
+    decompositions.clear();
+    
+    convexHulls = std::move(hulls);
+    for (size_t i = 0; i < convexHulls.size(); i++) {
+        processedMeshes.push_back(UploadHullMesh(CreateHullMesh(convexHulls[i], PieceColor(i))));
     }
+    BuildCollisionHulls();
+}
+
+
+
+// ------------------------------------------------------------------------------------------------------------- //
+// BuildCollisionHulls //
+// ------------------------------------------------------------------------------------------------------------- //
+
+// Query-side copies of convexHulls: the narrow phase shapes, their boxes for culling, the compact blob the
+// ray queries read, and the hierarchy over them. Rebuilt whenever the hulls change.
+void RObject::BuildCollisionHulls() {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_HULLS);
+    collisionHulls.resize(convexHulls.size());
+    threadPool.ParallelFor(convexHulls.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            collisionHulls[i] = CreateCollisionHull(convexHulls[i]);
+        }
+    });
+    pieceBounds = CreatePieceBounds(collisionHulls);
+    hullBlob = HullBlob::Create(convexHulls);
+    
+    if (hullVertexBudget > 0) hullTree.Build(convexHulls, GetAdjacentPieces(decompositions), hullVertexBudget, hullFaceBudget);
+    else hullTree.Build(convexHulls, GetAdjacentPieces(decompositions));
+}
+
+BoundsArray RObject::CreatePieceBounds(const std::vector<CollisionHull>& hulls) {
+    
+    std::vector<glm::vec3> boundsMin, boundsMax;
+    for (const CollisionHull& hull : hulls) {
+        boundsMin.push_back(hull.boundsMin);
+        boundsMax.push_back(hull.boundsMax);
+    }
+    return CreateBoundsArray(boundsMin, boundsMax);
+}
+
+// Pairs of pieces whose clusters share an edge, as indices into convexHulls.
+std::vector<std::pair<uint32_t, uint32_t>> RObject::GetAdjacentPieces(const std::vector<DecompositionGraph>& graphs) {
+    
+    std::vector<std::pair<uint32_t, uint32_t>> adjacentPieces;
+    for (const DecompositionGraph& graph : graphs) {
+        for (size_t i = 0; i < graph.neighbors.size(); i++) {
+            for (uint32_t neighbor : graph.neighbors[i]) {
+                if (neighbor > i) adjacentPieces.push_back({(uint32_t)(graph.firstPiece + i), (uint32_t)(graph.firstPiece + neighbor)});
+            }
+        }
+    }
+    return adjacentPieces;
+}
+
+// Closest piece hit by a world-space ray, found through the hull tree so only the pieces whose boxes
+// the ray passes are clipped against their planes.
+std::optional<HullTreeHit> RObject::RaycastHulls(const Ray& ray, float maxDistance = FLT_MAX) {
+    
+    glm::mat4 inverse = glm::inverse(CreateModelMatrix());
+    glm::vec3 origin = glm::vec3(inverse * glm::vec4(ray.origin, 1.0f));
+    glm::vec3 direction = glm::mat3(inverse) * ray.direction;
+    
+    const HullBlob& blob = GetHullBlob();
+    std::optional<HullTreeHit> closest;
+    GetHullTree().Raycast(origin, direction, maxDistance, [&](int piece, float currentMax) {
+        int enterPlane;
+        float distance = blob.Raycast(piece, origin, direction, currentMax, enterPlane);
+        if (distance < 0.0f || (closest && distance >= closest->intersection.distance)) return -1.0f;
+        
+        glm::vec3 normal = -ray.direction;
+        if (enterPlane >= 0) {
+            glm::vec3 localNormal = glm::vec3(blob.GetPlane(piece, enterPlane));
+            normal = glm::normalize(glm::transpose(glm::mat3(inverse)) * localNormal);
+        }
+        closest = HullTreeHit{piece, Intersection{ray.origin + ray.direction * distance, normal, distance}};
+        return distance;
+    });
+    return closest;
+}
+
+Mesh RObject::CreateHullMesh(const ConvexHull& hull, glm::vec3 color) {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_UPLOAD);
+    Mesh hullMesh{};
+    hullMesh.color = color;
+    
+    glm::vec3 centroid = ComputeHullCentroid(hull);
+    for (const glm::vec3& vertex : hull.vertices) {
+        glm::vec3 normal = vertex - centroid;
+        normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+        
+        hullMesh.vertices.insert(hullMesh.vertices.end(), {vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z, 0.0f, 0.0f});
+    }
+    for (const std::array<int, 3>& face : hull.faces) {
+        hullMesh.indices.insert(hullMesh.indices.end(), {(uint32_t)face[0], (uint32_t)face[1], (uint32_t)face[2]});
+    }
+    return hullMesh;
 }
 
 
@@ -154,8 +1059,11 @@ void RObject::Decompose(int maxClusters = 10) {
 // CreateModelMatrix //
 // ------------------------------------------------------------------------------------------------------------- //
 
+// Cached; only rebuilt after position, rotation or scale have changed.
 glm::mat4 RObject::CreateModelMatrix() {
     
+    if (modelMatrixValid && position == modelPosition && rotation == modelRotation && scale == modelScale) return modelMatrix;
+    
     glm::mat4 model = glm::mat4(1.0f);
     glm::mat4 translationMatrix = glm::mat4(1.0f);
     translationMatrix = glm::translate(translationMatrix, position);
@@ -169,10 +1077,18 @@ glm::mat4 RObject::CreateModelMatrix() {
     
     model = translationMatrix * rotationMatrix * scaleMatrix;
     
+    modelMatrix = model;
+    modelPosition = position;
+    modelRotation = rotation;
+    modelScale = scale;
+    modelMatrixValid = true;
+    
     return model;
 }
 
 Mesh RObject::CreateOpenGLMesh(Mesh convexMesh) {
+    MemoryStageScope memoryStage(MEMORY_STAGE_UPLOAD);
+    
     glGenVertexArrays(1, &convexMesh.vao);
     glGenBuffers(1, &convexMesh.vbo);
     glGenBuffers(1, &convexMesh.ibo);
@@ -184,16 +1100,21 @@ Mesh RObject::CreateOpenGLMesh(Mesh convexMesh) {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, convexMesh.ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, convexMesh.indices.size() * sizeof(uint32_t), convexMesh.indices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
+    MeshLayout::EnableAttributes();
 
     glBindVertexArray(0);
     
     return convexMesh;
 }
 
+// Hull meshes are only ever drawn, and picked through the hulls themselves, so the CPU copy of their
+// vertices is dropped once it is on the GPU. The indices stay for the draw counts.
+Mesh RObject::UploadHullMesh(const Mesh& hullMesh) {
+    
+    MemoryStageScope memoryStage(MEMORY_STAGE_UPLOAD);
+    Mesh uploaded = CreateOpenGLMesh(hullMesh);
+    std::vector<float>().swap(uploaded.vertices);
+    return uploaded;
+}
+
 #endif /* object_h */
@@ -79,16 +79,13 @@ RObject* Terrain::Create() {
     glGenBuffers(1, &m_mesh.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, m_mesh.vbo);
     //throw std::runtime_error(std::to_string(vertices.size()));
-    glBufferData(GL_ARRAY_BUFFER, TERRAIN_SIZE * TERRAIN_SIZE * 6 * sizeof(float), &m_mesh.vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, m_mesh.vertices.size() * sizeof(float), m_mesh.vertices.data(), GL_STATIC_DRAW);
     
     glGenBuffers(1, &m_mesh.ibo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_mesh.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (TERRAIN_SIZE - 1) * (TERRAIN_SIZE - 1) * 6 * sizeof(uint32_t), &m_mesh.indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_mesh.indices.size() * sizeof(uint32_t), m_mesh.indices.data(), GL_STATIC_DRAW);
     
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    MeshLayout::EnableAttributes();
     
     terrain->meshes.push_back(m_mesh);
     static_cast<Terrain*>(terrain)->Decompose(10);
@@ -112,20 +109,17 @@ void Terrain::Render(Shader shader) {
     ray.origin = camera.position;
     ray.direction = camera.mouseRayDirection;
     
-    glm::mat4 modelMatrix = CreateModelMatrix();
+    // Picking goes through the hulls, since the hull meshes keep no CPU copy of their vertices
+    std::optional<HullTreeHit> hit = RaycastHulls(ray);
     
-    for (Mesh mesh : processedMeshes) {
-        
-        std::optional<Intersection> intersect = Raycast(ray, GetTransformedVertices(mesh, modelMatrix), mesh.indices);
+    const std::vector<Mesh>& pieces = GetProcessedMeshes();
+    for (size_t i = 0; i < pieces.size(); i++) {
+        const Mesh& mesh = pieces[i];
         
         glBindVertexArray(mesh.vao);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), &mesh.vertices[0], GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), &mesh.indices[0], GL_STATIC_DRAW);
         
         shader.SetVector3("color", mesh.color);
-        if (intersect) {
+        if (hit && hit->piece == (int)i) {
             shader.SetVector3("color", glm::vec3(1.0f, 0.0f, 0.0f));
         }
         
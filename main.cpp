@@ -7,7 +7,42 @@
 
 #include "core/core.h"
 
+// Leading options apply to every mode: --memory-report <file> tracks allocations per pipeline stage, prints
+// them on exit and writes them to file as JSON; --memory-budget <MB> keeps decomposition under the budget;
+// --decomposition-cache <directory> loads assets with the hulls a farm left there.
 int main(int argc, const char * argv[]) {
     
-    initialize();
+    const char* executable = argv[0];
+    std::string memoryReport;
+    while (argc > 2) {
+        std::string option = argv[1];
+        if (option == "--memory-report") {
+            memoryReport = argv[2];
+            StartMemoryTracking();
+        }
+        else if (option == "--memory-budget") SetMemoryBudget((size_t)(std::atof(argv[2]) * 1024.0 * 1024.0));
+        else if (option == "--decomposition-cache") decompositionCacheDirectory = argv[2];
+        else break;
+        argc -= 2;
+        argv += 2;
+    }
+    
+    int status = 0;
+    if (argc > 1 && std::string(argv[1]) == "--bench-broadphase") {
+        BenchmarkBroadphase(argc > 2 ? std::atoi(argv[2]) : 10000, 300);
+    }
+    else if (argc > 4 && std::string(argv[1]) == "--decompose-farm") {
+        status = RunDecompositionFarm(executable, std::atoi(argv[2]), argv[3], std::vector<std::string>(argv + 4, argv + argc));
+    }
+    else if (argc > 2 && std::string(argv[1]) == "--farm-worker") {
+        status = RunFarmWorker(argv[2]);
+    }
+    else initialize();
+    
+    if (!memoryReport.empty()) {
+        PrintMemoryReport(std::cout);
+        std::ofstream report(memoryReport);
+        SaveMemoryReport(report);
+    }
+    return status;
 }